@@ -0,0 +1,160 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "corpus.hxx"
+
+#include <random>
+
+namespace
+{
+    void append(std::string & out, char32_t c)
+    {
+        if (c < 0x80)
+            out.push_back(static_cast<char>(c));
+        else if (c < 0x800)
+        {
+            out.push_back(static_cast<char>(0xC0 | (c >> 6)));
+            out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+        }
+        else if (c < 0x10000)
+        {
+            out.push_back(static_cast<char>(0xE0 | (c >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+        }
+        else
+        {
+            out.push_back(static_cast<char>(0xF0 | (c >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+        }
+    }
+
+    char32_t ascii(std::mt19937 & rng)
+    {
+        // mostly lower case letters with spaces, some punctuation and line breaks
+        unsigned const pick = rng() % 100;
+        if (pick < 15) return ' ';
+        if (pick < 17) return pick == 15 ? '.' : ',';
+        if (pick < 18) return '\n';
+        if (pick < 22) return 'A' + rng() % 26;
+        return 'a' + rng() % 26;
+    }
+
+    char32_t latin1(std::mt19937 & rng)
+    {
+        return rng() % 4 ? 0xC0 + rng() % 0x40 : ascii(rng);
+    }
+
+    char32_t cjk(std::mt19937 & rng)
+    {
+        unsigned const pick = rng() % 20;
+        if (!pick) return 0x3001; // ideographic comma
+        if (pick == 1) return ' ';
+        return 0x4E00 + rng() % 0x5200;
+    }
+
+    char32_t emoji(std::mt19937 & rng)
+    {
+        return rng() % 5 ? 0x1F300 + rng() % 0x700 : ' ';
+    }
+
+    template <typename Generator>
+    std::string generate(std::size_t size, std::mt19937 & rng, Generator generator)
+    {
+        std::string out;
+        out.reserve(size + 4);
+        while (out.size() < size)
+            append(out, generator(rng));
+        return out;
+    }
+
+    // switches between the scripts every few dozen characters
+    class mixed
+    {
+    public:
+        mixed()
+            : script_(0)
+            , left_(0)
+        {
+        }
+
+        char32_t operator () (std::mt19937 & rng)
+        {
+            if (!left_)
+            {
+                script_ = rng() % 4;
+                left_ = 1 + rng() % 60;
+            }
+            --left_;
+            switch (script_)
+            {
+            case 0: return ascii(rng);
+            case 1: return latin1(rng);
+            case 2: return cjk(rng);
+            default: return emoji(rng);
+            }
+        }
+
+    private:
+        unsigned script_;
+        unsigned left_;
+    };
+
+    std::string invalid(std::size_t size, std::mt19937 & rng)
+    {
+        static char const * const errors[] = {
+            "\xC0\xAF",         // overlong '/'
+            "\xED\xA0\x80",     // surrogate
+            "\xE2\x82",         // truncated
+            "\x80",             // stray continuation byte
+            "\xF5\x80\x80\x80", // above U+10FFFF
+            "\xF0\x9F\x98"      // truncated four byte sequence
+        };
+
+        std::string out;
+        out.reserve(size + 8);
+        mixed text;
+        while (out.size() < size)
+        {
+            std::size_t const run = 64 + rng() % 448;
+            for (std::size_t n = 0; n < run && out.size() < size; ++n)
+                append(out, text(rng));
+            out += errors[rng() % (sizeof(errors) / sizeof(errors[0]))];
+        }
+        return out;
+    }
+}
+
+namespace bench
+{
+    std::vector<corpus> make_corpora(std::size_t size)
+    {
+        std::mt19937 rng(2012);
+        std::vector<corpus> corpora;
+        corpora.push_back(corpus{ "ascii", generate(size, rng, ascii), true });
+        corpora.push_back(corpus{ "latin1", generate(size, rng, latin1), true });
+        corpora.push_back(corpus{ "cjk", generate(size, rng, cjk), true });
+        corpora.push_back(corpus{ "emoji", generate(size, rng, emoji), true });
+        corpora.push_back(corpus{ "mixed", generate(size, rng, mixed()), true });
+        corpora.push_back(corpus{ "invalid", invalid(size, rng), false });
+        return corpora;
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef UTF8PP_BENCH_CORPUS_HXX
+#define UTF8PP_BENCH_CORPUS_HXX
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace bench
+{
+    // generated benchmark input
+    struct corpus
+    {
+        char const * name;
+        // the encoded text (cut at a character boundary)
+        std::string bytes;
+        // false for the adversarial corpus
+        bool valid;
+    };
+
+    // Deterministic corpora of about size bytes each:
+    //   ascii   - English like words and punctuation
+    //   latin1  - mostly two byte characters (U+00C0 - U+00FF) between ASCII
+    //   cjk     - three byte CJK ideographs with some ASCII punctuation
+    //   emoji   - four byte characters with spaces
+    //   mixed   - runs of all of the above
+    //   invalid - mixed text with invalid sequences (overlong, surrogates, truncated,
+    //             stray continuation bytes, bytes above 0xF4) every few hundred bytes
+    std::vector<corpus> make_corpora(std::size_t size);
+}
+
+#endif // UTF8PP_BENCH_CORPUS_HXX
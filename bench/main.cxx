@@ -0,0 +1,610 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// utf8pp_bench [--size=BYTES] [--filter=TEXT] [--output=FILE]
+//
+// Runs every benchmark on every generated corpus (see corpus.hxx) and writes the results
+// as JSON to stdout (or FILE), a readable summary goes to stderr. --filter selects the
+// benchmarks whose "benchmark/corpus" name contains TEXT. index_sized and walk_sized run
+// on generated strings of 1000 to 64000 characters instead (corpus "mixed_<characters>"),
+// their ns_per_char is per accessed character.
+//
+// Every benchmark is repeated until it ran at least 3 times and 0.2 seconds, the fastest
+// run is reported. Throughput is bytes of UTF-8 per second, ns_per_char divides by the
+// number of characters (for the invalid corpus: the number of non continuation bytes).
+
+#define UTF8PP_TEST
+
+#include "corpus.hxx"
+
+#include "core/string.hxx"
+#include "core/string_view.hxx"
+#include "core/memory_resource.hxx"
+#include "core/intern_pool.hxx"
+#include "core/line_reader.hxx"
+#include "core/normalization.hxx"
+#include "core/case_mapping.hxx"
+#include "core/decoding.hxx"
+#include "conversion/encoding_cast.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    typedef std::chrono::steady_clock clock_type;
+
+    double seconds_since(clock_type::time_point start)
+    {
+        return std::chrono::duration<double>(clock_type::now() - start).count();
+    }
+
+    // results are added up here, so the compiler can't drop the work
+    std::size_t volatile sink;
+
+    struct result
+    {
+        std::string benchmark;
+        std::string corpus;
+        std::size_t bytes;
+        std::size_t characters;
+        double seconds;
+    };
+
+    struct request_result
+    {
+        std::string resource;
+        double allocations;
+        double p50;
+        double p99;
+    };
+
+    struct options
+    {
+        std::size_t size;
+        std::string filter;
+        std::string output;
+    };
+
+    // the fastest of at least 3 runs taking 0.2 seconds together
+    template <typename Function>
+    double measure(Function function)
+    {
+        double best = std::numeric_limits<double>::max(), total = 0;
+        for (unsigned runs = 0; runs < 3 || (total < 0.2 && runs < 10000); ++runs)
+        {
+            clock_type::time_point const start = clock_type::now();
+            sink = sink + function();
+            double const seconds = seconds_since(start);
+            best = std::min(best, seconds);
+            total += seconds;
+        }
+        return best;
+    }
+
+    std::size_t count_characters(std::string const & bytes)
+    {
+        std::size_t characters = 0;
+        for (char c : bytes)
+            characters += (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+        return characters;
+    }
+
+    // pieces of at most size bytes, cut at character boundaries
+    std::vector<std::string> cut(std::string const & bytes, std::size_t size)
+    {
+        std::vector<std::string> pieces;
+        for (std::size_t pos = 0; pos < bytes.size();)
+        {
+            std::size_t end = std::min(pos + size, bytes.size());
+            while (end < bytes.size() && end > pos + 1 && (static_cast<unsigned char>(bytes[end]) & 0xC0) == 0x80)
+                --end;
+            pieces.push_back(bytes.substr(pos, end - pos));
+            pos = end;
+        }
+        return pieces;
+    }
+
+    class runner
+    {
+    public:
+        explicit runner(options const & opts)
+            : opts_(opts)
+        {
+        }
+
+        template <typename Function>
+        void run(char const * benchmark, bench::corpus const & corpus, std::size_t characters, Function function)
+        {
+            std::string const name = std::string(benchmark) + "/" + corpus.name;
+            if (name.find(opts_.filter) == std::string::npos)
+                return;
+
+            result const r = { benchmark, corpus.name, corpus.bytes.size(), characters, measure(function) };
+            std::cerr << name << ":\t" << r.bytes / r.seconds / 1e9 << " GB/s\t"
+                << r.seconds * 1e9 / r.characters << " ns/char\n";
+            results.push_back(r);
+        }
+
+        bool selected(char const * benchmark) const
+        {
+            return std::string(benchmark).find(opts_.filter) != std::string::npos;
+        }
+
+        std::vector<result> results;
+        std::vector<request_result> requests;
+
+    private:
+        options opts_;
+    };
+
+    void bench_valid(runner & run, bench::corpus const & corpus)
+    {
+        utf8::string const text(corpus.bytes);
+        std::size_t const characters = text.length();
+
+        run.run("validate", corpus, characters, [&]() {
+            utf8::string_view const view(corpus.bytes);
+            return static_cast<std::size_t>(view.validate());
+        });
+
+        run.run("construct", corpus, characters, [&]() {
+            return utf8::string(corpus.bytes).size();
+        });
+
+        // the lossy modes on valid input, for comparison with the invalid corpus
+        run.run("construct_replace", corpus, characters, [&]() {
+            return utf8::string(corpus.bytes, utf8::replace_invalid).size();
+        });
+
+        run.run("iterate", corpus, characters, [&]() {
+            std::size_t sum = 0;
+            for (utf8::value_t c : text)
+                sum += c;
+            return sum;
+        });
+
+        // uses the offset index (built by the first run)
+        run.run("index", corpus, characters, [&]() {
+            std::size_t sum = 0;
+            for (unsigned index = 0; index < characters; ++index)
+                sum += text[index];
+            return sum;
+        });
+
+        std::vector<utf8::string> pieces;
+        for (std::string const & piece : cut(corpus.bytes, 200))
+            pieces.push_back(utf8::string(piece));
+        run.run("concatenate", corpus, characters, [&]() {
+            utf8::string all;
+            for (utf8::string const & piece : pieces)
+                all += piece;
+            return all.size();
+        });
+        run.run("concatenate_reserved", corpus, characters, [&]() {
+            std::size_t total = 0;
+            for (utf8::string const & piece : pieces)
+                total += piece.size();
+            utf8::string all;
+            all.reserve(total);
+            for (utf8::string const & piece : pieces)
+                all += piece;
+            return all.size();
+        });
+        run.run("concatenate_rvalue", corpus, characters, [&]() {
+            utf8::string all;
+            for (utf8::string const & piece : pieces)
+                all = std::move(all) + piece;
+            return all.size();
+        });
+
+        run.run("hash", corpus, characters, [&]() {
+            std::size_t sum = 0;
+            std::hash<utf8::string> const hash;
+            for (utf8::string const & piece : pieces)
+                sum += hash(piece);
+            return sum;
+        });
+        // every piece twice: once added, once found
+        run.run("intern", corpus, characters, [&]() {
+            utf8::intern_pool pool;
+            std::size_t sum = 0;
+            for (utf8::string const & piece : pieces)
+                sum += pool.intern(piece).size();
+            for (utf8::string const & piece : pieces)
+                sum += pool.intern(piece).size();
+            return sum / 2;
+        });
+
+        // the generated corpora are in NFC, so only the quick check runs for it
+        run.run("is_normalized", corpus, characters, [&]() {
+            return std::size_t(utf8::is_normalized(text));
+        });
+        run.run("normalize_nfc", corpus, characters, [&]() {
+            return utf8::normalize(text).size();
+        });
+        run.run("normalize_nfd", corpus, characters, [&]() {
+            return utf8::normalize(text, utf8::normalization_form::nfd).size();
+        });
+
+        utf8::string const upper = utf8::to_upper(text);
+        run.run("to_lower", corpus, characters, [&]() {
+            return utf8::to_lower(text).size();
+        });
+        run.run("to_upper", corpus, characters, [&]() {
+            return utf8::to_upper(text).size();
+        });
+        run.run("casefold", corpus, characters, [&]() {
+            return utf8::casefold(text).size();
+        });
+        run.run("iequals", corpus, characters, [&]() {
+            return std::size_t(utf8::iequals(text, upper));
+        });
+
+        std::u32string const utf32 = utf8::encoding_cast<std::u32string>(text);
+        std::u16string const utf16 = utf8::encoding_cast<std::u16string>(text);
+        std::wstring const wide = utf8::encoding_cast<std::wstring>(text);
+
+        run.run("push_back", corpus, characters, [&]() {
+            utf8::string all;
+            for (char32_t c : utf32)
+                all.push_back(c);
+            return all.size();
+        });
+
+        // conversion to UTF-32: iterator and push_back against the block decoder
+        std::u32string pushed, decoded(characters, U'\0');
+        pushed.reserve(characters);
+        run.run("iterate_push_back", corpus, characters, [&]() {
+            pushed.clear();
+            for (utf8::value_t c : text)
+                pushed.push_back(c);
+            return pushed.size();
+        });
+        run.run("decode", corpus, characters, [&]() {
+            return utf8::decode(text.bytes(), text.size(), &decoded[0]);
+        });
+
+        run.run("to_utf32", corpus, characters, [&]() {
+            return utf8::encoding_cast<std::u32string>(text).size();
+        });
+        run.run("to_utf16", corpus, characters, [&]() {
+            return utf8::encoding_cast<std::u16string>(text).size();
+        });
+        run.run("to_wstring", corpus, characters, [&]() {
+            return utf8::encoding_cast<std::wstring>(text).size();
+        });
+        run.run("from_utf32", corpus, characters, [&]() {
+            return utf8::encoding_cast<utf8::string>(utf32).size();
+        });
+        run.run("from_utf16", corpus, characters, [&]() {
+            return utf8::encoding_cast<utf8::string>(utf16).size();
+        });
+        run.run("from_wstring", corpus, characters, [&]() {
+            return utf8::encoding_cast<utf8::string>(wide).size();
+        });
+
+        // lines of about 100 bytes, read from an in-memory stream
+        bench::corpus lines = { corpus.name, std::string(), true };
+        for (std::string const & piece : cut(corpus.bytes, 100))
+            lines.bytes += piece + "\n";
+        std::size_t const line_characters = count_characters(lines.bytes);
+        run.run("getline", lines, line_characters, [&]() {
+            std::istringstream is(lines.bytes);
+            utf8::string line;
+            std::size_t sum = 0;
+            while (utf8::getline(is, line))
+                sum += line.length() + 1;
+            return sum;
+        });
+        run.run("line_reader", lines, line_characters, [&]() {
+            std::istringstream is(lines.bytes);
+            utf8::line_reader reader(is);
+            utf8::string_view line;
+            std::size_t sum = 0;
+            while (reader.next(line))
+                sum += line.length() + 1;
+            return sum;
+        });
+        run.run("line_reader_copy", lines, line_characters, [&]() {
+            std::istringstream is(lines.bytes);
+            utf8::line_reader reader(is);
+            utf8::string line;
+            std::size_t sum = 0;
+            while (reader.next(line))
+                sum += line.length() + 1;
+            return sum;
+        });
+    }
+
+    // character access without the offset index: walk from the first character
+    utf8::value_t walk(utf8::string const & str, std::size_t index)
+    {
+        utf8::string::const_iterator it = str.begin();
+        for (; index; --index)
+            ++it;
+        return *it;
+    }
+
+    // Random access into strings of growing length, 1000 positions spread over each string
+    // (ns_per_char is per access): with the offset index the time per access stays flat,
+    // walking from the start grows with the length.
+    void bench_index_sizes(runner & run)
+    {
+        utf8::value_t const alphabet[] = { 'a', 'b', 0xE9, 0x20AC, 0x4E2D, 0x1F600 };
+        std::size_t const accesses = 1000;
+        for (std::size_t characters = 1000; characters <= 64000; characters *= 4)
+        {
+            utf8::string text;
+            for (std::size_t n = 0; n < characters; ++n)
+                text.push_back(alphabet[n % 6]);
+            std::size_t const step = characters / accesses;
+
+            std::string const name = "mixed_" + std::to_string(characters);
+            bench::corpus const corpus = { name.c_str(), std::string(reinterpret_cast<char const *>(text.bytes()), text.size()), true };
+            run.run("index_sized", corpus, accesses, [&]() {
+                std::size_t sum = 0;
+                for (std::size_t index = 0; index < characters; index += step)
+                    sum += text[static_cast<unsigned>(index)];
+                return sum;
+            });
+            run.run("walk_sized", corpus, accesses, [&]() {
+                std::size_t sum = 0;
+                for (std::size_t index = 0; index < characters; index += step)
+                    sum += walk(text, index);
+                return sum;
+            });
+        }
+    }
+
+    // the input is handled as records of 4 KiB, most of them are rejected
+    void bench_invalid(runner & run, bench::corpus const & corpus)
+    {
+        std::size_t const characters = count_characters(corpus.bytes);
+        std::vector<std::string> const records = cut(corpus.bytes, 4096);
+
+        run.run("validate", corpus, characters, [&]() {
+            std::size_t valid = 0;
+            for (std::string const & record : records)
+                valid += utf8::string_view(record).validate();
+            return valid;
+        });
+
+        run.run("construct", corpus, characters, [&]() {
+            std::size_t rejected = 0;
+            for (std::string const & record : records)
+            {
+                try { utf8::string const str(record); }
+                catch (std::invalid_argument const &) { ++rejected; }
+            }
+            return rejected;
+        });
+
+        run.run("construct_checked", corpus, characters, [&]() {
+            std::size_t rejected = 0;
+            for (std::string const & record : records)
+            {
+                utf8::check_result result;
+                utf8::string const str(record, result);
+                rejected += !result;
+            }
+            return rejected;
+        });
+
+        run.run("construct_replace", corpus, characters, [&]() {
+            std::size_t size = 0;
+            for (std::string const & record : records)
+                size += utf8::string(record, utf8::replace_invalid).size();
+            return size;
+        });
+
+        run.run("construct_skip", corpus, characters, [&]() {
+            std::size_t size = 0;
+            for (std::string const & record : records)
+                size += utf8::string(record, utf8::skip_invalid).size();
+            return size;
+        });
+    }
+
+    // counts the allocations reaching the default resource (shared by all threads)
+    class counting_resource : public utf8::memory_resource
+    {
+    public:
+        counting_resource()
+            : allocations(0)
+        {
+        }
+
+        std::atomic<std::size_t> allocations;
+
+    private:
+        void * do_allocate(std::size_t bytes, std::size_t alignment) override
+        {
+            ++allocations;
+            return utf8::resource_or_default(nullptr)->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void * p, std::size_t bytes, std::size_t alignment) override
+        {
+            utf8::resource_or_default(nullptr)->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(utf8::memory_resource const & other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+
+    // one request: builds a response out of header lines too long for short strings
+    std::size_t handle_request(unsigned request, utf8::memory_resource * resource)
+    {
+        utf8::string const separator(u8": ", resource);
+        utf8::string response(nullptr, resource);
+        for (unsigned field = 0; field < 32; ++field)
+        {
+            utf8::string key(u8"X-Request-Field-Näme-", resource);
+            key.push_back(U'0' + field % 10);
+            utf8::string value(u8"välue with some € signs and an emoji 😀 for ", resource);
+            value.push_back(U'a' + (request + field) % 26);
+            response += key + separator + value;
+        }
+        return response.length();
+    }
+
+    // Request-per-thread workload: every thread handles its requests one after another,
+    // either with the default resource or with an arena released after each request.
+    void bench_arena(runner & run)
+    {
+        unsigned const threads = 4, requests = 2000;
+
+        for (int arena = 0; arena < 2; ++arena)
+        {
+            counting_resource counting;
+            std::vector<std::vector<double>> latencies(threads);
+            std::vector<std::thread> workers;
+            for (unsigned t = 0; t < threads; ++t)
+            {
+                workers.push_back(std::thread([&, t]()
+                {
+                    static std::size_t const BUFFER_SIZE = 16384;
+                    std::vector<unsigned char> buffer(BUFFER_SIZE);
+                    utf8::arena_resource local(buffer.data(), buffer.size(), &counting);
+                    std::size_t characters = 0;
+                    for (unsigned r = 0; r < requests; ++r)
+                    {
+                        clock_type::time_point const start = clock_type::now();
+                        characters += handle_request(r, arena ? static_cast<utf8::memory_resource *>(&local) : &counting);
+                        local.release();
+                        latencies[t].push_back(seconds_since(start));
+                    }
+                    sink = sink + characters;
+                }));
+            }
+            for (std::thread & worker : workers)
+                worker.join();
+
+            std::vector<double> all;
+            for (std::vector<double> const & latency : latencies)
+                all.insert(all.end(), latency.begin(), latency.end());
+            std::sort(all.begin(), all.end());
+
+            request_result const r = {
+                arena ? "arena" : "default",
+                static_cast<double>(counting.allocations) / all.size(),
+                all[all.size() / 2],
+                all[all.size() * 99 / 100]
+            };
+            std::cerr << "requests/" << r.resource << ":\t" << r.allocations << " allocations/request\t"
+                << r.p50 * 1e6 << " us p50\t" << r.p99 * 1e6 << " us p99\n";
+            run.requests.push_back(r);
+        }
+    }
+
+    void write_json(std::ostream & os, options const & opts, runner const & run)
+    {
+        os << "{\n  \"library\": \"utf8pp\",\n  \"corpus_size\": " << opts.size << ",\n  \"results\": [";
+        for (std::size_t n = 0; n < run.results.size(); ++n)
+        {
+            result const & r = run.results[n];
+            os << (n ? ",\n" : "\n")
+                << "    {\"benchmark\": \"" << r.benchmark << "\", \"corpus\": \"" << r.corpus
+                << "\", \"bytes\": " << r.bytes << ", \"characters\": " << r.characters
+                << ", \"seconds\": " << r.seconds
+                << ", \"gb_per_s\": " << r.bytes / r.seconds / 1e9
+                << ", \"ns_per_char\": " << r.seconds * 1e9 / r.characters << "}";
+        }
+        os << "\n  ],\n  \"requests\": [";
+        for (std::size_t n = 0; n < run.requests.size(); ++n)
+        {
+            request_result const & r = run.requests[n];
+            os << (n ? ",\n" : "\n")
+                << "    {\"resource\": \"" << r.resource << "\", \"allocations_per_request\": " << r.allocations
+                << ", \"p50_us\": " << r.p50 * 1e6 << ", \"p99_us\": " << r.p99 * 1e6 << "}";
+        }
+        os << "\n  ]\n}\n";
+    }
+
+    bool parse(int argc, char ** argv, options & opts)
+    {
+        opts.size = 1 << 20;
+        for (int n = 1; n < argc; ++n)
+        {
+            char const * const arg = argv[n];
+            if (!std::strncmp(arg, "--size=", 7))
+                opts.size = std::strtoul(arg + 7, nullptr, 10);
+            else if (!std::strncmp(arg, "--filter=", 9))
+                opts.filter = arg + 9;
+            else if (!std::strncmp(arg, "--output=", 9))
+                opts.output = arg + 9;
+            else
+                return false;
+        }
+        return opts.size > 0;
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    options opts;
+    if (!parse(argc, argv, opts))
+    {
+        std::cerr << "usage: " << argv[0] << " [--size=BYTES] [--filter=TEXT] [--output=FILE]\n";
+        return 2;
+    }
+
+    runner run(opts);
+    for (bench::corpus const & corpus : bench::make_corpora(opts.size))
+    {
+        if (corpus.valid)
+            bench_valid(run, corpus);
+        else
+            bench_invalid(run, corpus);
+    }
+    bench_index_sizes(run);
+    if (run.selected("requests"))
+        bench_arena(run);
+
+    if (opts.output.empty())
+        write_json(std::cout, opts, run);
+    else
+    {
+        std::ofstream file(opts.output.c_str());
+        write_json(file, opts, run);
+        if (!file)
+        {
+            std::cerr << "could not write " << opts.output << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
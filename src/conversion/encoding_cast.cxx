@@ -18,6 +18,7 @@
 */
 
 #include "encoding_cast.hxx"
+#include "decoding.hxx"
 
 #include <iostream>
 
@@ -35,22 +36,20 @@ namespace utf8
             {
                 static std::wstring to_wstring(utf8::string const & src)
                 {
-                    std::wstring result;
-                    result.reserve(src.length());
-                    for (auto c : src)
-                    {
-                        result.push_back(c);
-                    }
+                    // one code unit per character, decoded in blocks (ASCII is just widened)
+                    std::wstring result(src.length(), L'\0');
+                    if (src.is_ascii())
+                        std::copy(src.bytes(), src.bytes() + src.size(), result.begin());
+                    else
+                        decode(src.bytes(), src.size(), &result[0]);
                     return result;
                 }
 
-                static utf8::string from_wstring(std::wstring const & src)
+                static utf8::string from_wstring(std::wstring const & src, memory_resource * resource)
                 {
-                    utf8::string result;
-                    for (auto c : src)
-                    {
-                        result.push_back(c);
-                    }
+                    // sized up front and encoded in a single allocation
+                    utf8::string result(nullptr, resource);
+                    result.append(src.data(), src.size());
                     return result;
                 }
             };
@@ -60,49 +59,28 @@ namespace utf8
             {
                 static std::wstring to_wstring(utf8::string const & src)
                 {
-                    std::wstring result;
-                    result.reserve(src.length() * 2);
-                    for (auto c : src)
-                    {
-                        if (c <= 0xFFFF)
-                            result.push_back(static_cast<wchar_t>(c));
-                        else
-                        {
-                            // build surrogate pair
-                            c -= 0x10000;
-                            wchar_t high    = (0x36 << 10) | ((c >> 10) & 0x3FF),
-                                    low     = (0x37 << 10) | (c & 0x3FF);
-                            result.push_back(high);
-                            result.push_back(low);
-                        }
-                    }
+                    // characters above U+FFFF become surrogate pairs
+                    std::wstring result(src.max_width() <= 3 ? src.length() : wide_length(src.bytes(), src.size()), L'\0');
+                    if (src.is_ascii())
+                        std::copy(src.bytes(), src.bytes() + src.size(), result.begin());
+                    else
+                        decode(src.bytes(), src.size(), &result[0]);
                     return result;
                 }
 
-                static utf8::string from_wstring(std::wstring const & src)
+                static utf8::string from_wstring(std::wstring const & src, memory_resource * resource)
                 {
-                    utf8::string result;
-                    value_t val = 0;
-                    for (auto c : src)
-                    {
-                        if ((c >> 10) == 0x36) // start of surrogate
-                            val = c & 0x3FF;
-                        else if ((c >> 10) == 0x37) // end of surrogate
-                        {
-                            result.push_back(0x10000 + ((val << 10) | (c & 0x3FF)));
-                            val = 0;
-                        }
-                        else
-                            result.push_back(c);
-                    }
+                    // surrogate pairs are checked while sizing the output
+                    utf8::string result(nullptr, resource);
+                    result.append(src.data(), src.size());
                     return result;
                 }
             };
         }
 
-        utf8::string wstring2utf8(std::wstring const & src)
+        utf8::string wstring2utf8(std::wstring const & src, memory_resource * resource /* = nullptr */)
         {
-            return detail::converter<sizeof(wchar_t)>::from_wstring(src);
+            return detail::converter<sizeof(wchar_t)>::from_wstring(src, resource);
         }
 
         std::wstring utf82wstring(utf8::string const & src)
@@ -24,10 +24,13 @@
 
 #ifdef UTF8PP_TEST
 #include "../core/string.hxx"
+#include "../core/decoding.hxx"
 #else
 #include "string.hxx"
+#include "decoding.hxx"
 #endif
 
+#include <algorithm>
 #include <typeinfo>
 
 namespace utf8
@@ -35,7 +38,8 @@ namespace utf8
     namespace platform
     {
         // platform dependent std::wstring to utf8::string converter (Unix/Linux has 32 bit wchar_t while Windows has 16 bit wchar_t)
-        utf8::string wstring2utf8(std::wstring const & src);
+        // (the result allocates from the given resource, nullptr selects the default one)
+        utf8::string wstring2utf8(std::wstring const & src, memory_resource * resource = nullptr);
         // the opposite conversion
         std::wstring utf82wstring(utf8::string const & src);
     }
@@ -51,8 +55,10 @@ namespace utf8
             static_assert(
                 typeid(Type) == typeid(std::string) ||
                 typeid(Type) == typeid(std::wstring) ||
+                typeid(Type) == typeid(std::u16string) ||
+                typeid(Type) == typeid(std::u32string) ||
                 typeid(Type) == typeid(utf8::string)
-                , "Unsupported type! Only std::string, std::wstring and utf8::string are allowed."
+                , "Unsupported type! Only std::string, std::wstring, std::u16string, std::u32string and utf8::string are allowed."
             );
 
             static Type convert(Type const & src)
@@ -65,18 +71,18 @@ namespace utf8
         template <>
         struct encoding_cast<utf8::string, std::string>
         {
-            static utf8::string convert(std::string const & src)
+            static utf8::string convert(std::string const & src, memory_resource * resource = nullptr)
             {
-                return utf8::string(src);
+                return utf8::string(src, resource);
             }
         };
 
         template <>
         struct encoding_cast<utf8::string, std::wstring>
         {
-            static utf8::string convert(std::wstring const & src)
+            static utf8::string convert(std::wstring const & src, memory_resource * resource = nullptr)
             {
-                return platform::wstring2utf8(src);
+                return platform::wstring2utf8(src, resource);
             }
         };
         
@@ -88,6 +94,60 @@ namespace utf8
                 return platform::utf82wstring(src);
             }
         };
+
+        // UTF-16 and UTF-32 don't depend on the platform
+        template <>
+        struct encoding_cast<utf8::string, std::u16string>
+        {
+            // throws an std::invalid_argument exception on unpaired surrogates
+            static utf8::string convert(std::u16string const & src, memory_resource * resource = nullptr)
+            {
+                utf8::string result(nullptr, resource);
+                result.append(src.data(), src.size());
+                return result;
+            }
+        };
+
+        template <>
+        struct encoding_cast<std::u16string, utf8::string>
+        {
+            static std::u16string convert(utf8::string const & src)
+            {
+                // without four byte characters there are no surrogate pairs
+                std::u16string result(src.max_width() <= 3 ? src.length() : utf8::utf16_length(src.bytes(), src.size()), u'\0');
+                if (src.is_ascii())
+                    std::copy(src.bytes(), src.bytes() + src.size(), result.begin());
+                else
+                    utf8::decode(src.bytes(), src.size(), &result[0]);
+                return result;
+            }
+        };
+
+        template <>
+        struct encoding_cast<utf8::string, std::u32string>
+        {
+            // throws an std::invalid_argument exception on surrogates and values above U+10FFFF
+            static utf8::string convert(std::u32string const & src, memory_resource * resource = nullptr)
+            {
+                utf8::string result(nullptr, resource);
+                result.append(src.data(), src.size());
+                return result;
+            }
+        };
+
+        template <>
+        struct encoding_cast<std::u32string, utf8::string>
+        {
+            static std::u32string convert(utf8::string const & src)
+            {
+                std::u32string result(src.length(), U'\0');
+                if (src.is_ascii())
+                    std::copy(src.bytes(), src.bytes() + src.size(), result.begin());
+                else
+                    utf8::decode(src.bytes(), src.size(), &result[0]);
+                return result;
+            }
+        };
     }
 
     template <typename TargetType, typename SourceType>
@@ -95,6 +155,13 @@ namespace utf8
     {
         return detail::encoding_cast<TargetType, SourceType>::convert(src);
     }
+
+    // conversions to utf8::string allocating from the given resource
+    template <typename TargetType, typename SourceType>
+    inline TargetType encoding_cast(SourceType const & src, memory_resource * resource)
+    {
+        return detail::encoding_cast<TargetType, SourceType>::convert(src, resource);
+    }
 }
 
 #endif // UTF8PP_CONVERSION_ENCODINGCAST_HXX
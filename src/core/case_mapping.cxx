@@ -0,0 +1,441 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "case_mapping.hxx"
+#include "case_tables.hxx"
+#include "decoding.hxx"
+#include "encoding.hxx"
+#include "validation.hxx"
+#include "detail.hxx"
+
+#include <algorithm>
+
+#include <cstdint>
+
+namespace
+{
+    using namespace utf8;
+    using namespace utf8::case_tables;
+    using utf8::detail::count_trailing_zeros;
+    using utf8::detail::decode_valid;
+
+    // bytes mapped before they are appended to the result
+    std::size_t const BUFFER = 1024;
+
+#ifdef UTF8PP_SSE2
+    // Flips the case of the ASCII letters of the given range (the bytes just outside of it are given).
+    // Bytes above 0x7F are negative for the signed comparisons, so they are never in the range.
+    __m128i map_ascii(__m128i block, __m128i before, __m128i after)
+    {
+        __m128i const letters = _mm_and_si128(_mm_cmpgt_epi8(block, before), _mm_cmplt_epi8(block, after));
+        return _mm_xor_si128(block, _mm_and_si128(letters, _mm_set1_epi8(0x20)));
+    }
+
+    // the range of the letters changed by the mapping
+    __m128i ascii_before(unsigned mapping)
+    {
+        return _mm_set1_epi8(mapping == UPPER ? 'a' - 1 : 'A' - 1);
+    }
+
+    __m128i ascii_after(unsigned mapping)
+    {
+        return _mm_set1_epi8(mapping == UPPER ? 'z' + 1 : 'Z' + 1);
+    }
+#endif
+
+    byte_t map_ascii(byte_t c, unsigned mapping)
+    {
+        unsigned const first = mapping == UPPER ? 'a' : 'A';
+        return c - first < 26u ? static_cast<byte_t>(c ^ 0x20) : c;
+    }
+
+    value_t shifted(value_t c, std::int32_t delta)
+    {
+        return static_cast<value_t>(static_cast<std::int32_t>(c) + delta);
+    }
+
+    // Decodes an ASCII or two byte character (lead < 0xE0) without branching on its size,
+    // as they are mixed unpredictably in most texts. The byte after the lead has to exist.
+    value_t decode_narrow(byte_t const * strm, std::size_t pos, unsigned & bytes)
+    {
+        value_t const lead = strm[pos];
+        bytes = 1 + (lead >> 7);
+        value_t const pair = ((lead & 0x1F) << 6) | (strm[pos + 1] & 0x3F);
+        return lead < 0x80 ? lead : pair;
+    }
+
+    // reads the case folded characters of valid UTF-8
+    class folded_reader
+    {
+    public:
+        folded_reader(byte_t const * strm, std::size_t size)
+            : strm_(strm)
+            , size_(size)
+            , pos_(0)
+            , pending_(nullptr)
+            , count_(0)
+        {
+        }
+
+        // the next folded character (END_OF_STRING at the end)
+        value_t next()
+        {
+            if (count_)
+            {
+                --count_;
+                return *pending_++;
+            }
+            if (pos_ == size_)
+                return END_OF_STRING;
+            if (strm_[pos_] < 0xE0 && pos_ + 1 < size_)
+            {
+                unsigned bytes;
+                value_t const c = decode_narrow(strm_, pos_, bytes);
+                property const & p = lookup(c);
+                if (!p.expansion[FOLD])
+                {
+                    pos_ += bytes;
+                    return shifted(c, p.delta[FOLD]);
+                }
+            }
+
+            value_t const c = decode_valid(strm_, pos_);
+            property const & p = lookup(c);
+            if (std::uint16_t const expansion = p.expansion[FOLD])
+            {
+                count_ = expansions[expansion] - 1;
+                pending_ = expansions + expansion + 2;
+                return expansions[expansion + 1];
+            }
+            return shifted(c, p.delta[FOLD]);
+        }
+
+#ifdef UTF8PP_SSE2
+        // true if the next 16 bytes can be compared as a block
+        bool at_block() const
+        {
+            return !count_ && pos_ + 16 <= size_;
+        }
+
+        __m128i block() const
+        {
+            return _mm_loadu_si128(reinterpret_cast<__m128i const *>(strm_ + pos_));
+        }
+
+        byte_t byte(std::size_t offset) const
+        {
+            return strm_[pos_ + offset];
+        }
+
+        void skip(std::size_t count)
+        {
+            pos_ += count;
+        }
+#endif
+
+    private:
+        byte_t const * strm_;
+        std::size_t size_;
+        std::size_t pos_;
+        // the rest of a folding to several characters
+        char32_t const * pending_;
+        unsigned count_;
+    };
+}
+
+namespace utf8
+{
+    namespace detail
+    {
+        class case_mapper
+        {
+        public:
+            // maps valid UTF-8 and appends it to the result
+            static void map(byte_t const * strm, std::size_t size, unsigned mapping, string & result)
+            {
+                byte_t buffer[BUFFER];
+                std::size_t fill = 0, length = 0;
+                unsigned width = 0;
+#ifdef UTF8PP_SSE2
+                __m128i const before = ascii_before(mapping), after = ascii_after(mapping);
+#endif
+                for (std::size_t pos = 0; pos < size; )
+                {
+                    // room for a block and a character mapping to three four byte characters
+                    if (fill + 32 > BUFFER)
+                    {
+                        result.append_bytes(buffer, fill, length, width);
+                        fill = length = 0;
+                    }
+#ifdef UTF8PP_SSE2
+                    if (pos + 16 <= size)
+                    {
+                        // other bytes are stored unchanged, only the leading ASCII ones are kept
+                        __m128i const block = _mm_loadu_si128(reinterpret_cast<__m128i const *>(strm + pos));
+                        _mm_storeu_si128(reinterpret_cast<__m128i *>(buffer + fill), map_ascii(block, before, after));
+                        unsigned const mask = static_cast<unsigned>(_mm_movemask_epi8(block));
+                        unsigned const ascii = mask ? count_trailing_zeros(mask) : 16;
+                        fill += ascii;
+                        length += ascii;
+                        pos += ascii;
+                        width = std::max(width, ascii ? 1u : 0u);
+                        // otherwise a non ASCII character follows
+                        if (ascii == 16)
+                            continue;
+                    }
+#endif
+                    if (strm[pos] < 0xE0 && pos + 1 < size)
+                    {
+                        unsigned bytes;
+                        value_t const c = decode_narrow(strm, pos, bytes);
+                        property const & p = lookup(c);
+                        value_t const mapped = shifted(c, p.delta[mapping]);
+                        if (!p.expansion[mapping] && mapped < 0x800)
+                        {
+                            // both bytes are written, the second one is overwritten later for ASCII
+                            unsigned const mapped_bytes = 1 + (mapped >= 0x80);
+                            buffer[fill] = static_cast<byte_t>(mapped < 0x80 ? mapped : 0xC0 | (mapped >> 6));
+                            buffer[fill + 1] = static_cast<byte_t>(0x80 | (mapped & 0x3F));
+                            fill += mapped_bytes;
+                            pos += bytes;
+                            ++length;
+                            width = std::max(width, mapped_bytes);
+                            continue;
+                        }
+                    }
+                    if (strm[pos] < 0x80)
+                    {
+                        buffer[fill++] = map_ascii(strm[pos++], mapping);
+                        ++length;
+                        width = std::max(width, 1u);
+                        continue;
+                    }
+
+                    std::size_t const start = pos;
+                    value_t const c = decode_valid(strm, pos);
+                    property const & p = lookup(c);
+                    if (!p.delta[mapping] && !p.expansion[mapping])
+                    {
+                        // copied as it is
+                        unsigned const bytes = static_cast<unsigned>(pos - start);
+                        std::copy(strm + start, strm + pos, buffer + fill);
+                        fill += bytes;
+                        ++length;
+                        width = std::max(width, bytes);
+                    }
+                    else if (std::uint16_t const expansion = p.expansion[mapping])
+                    {
+                        for (char32_t const * e = expansions + expansion, * end = e + 1 + *e; ++e != end; ++length)
+                        {
+                            unsigned const bytes = encode(*e, buffer + fill);
+                            fill += bytes;
+                            width = std::max(width, bytes);
+                        }
+                    }
+                    else
+                    {
+                        unsigned const bytes = encode(shifted(c, p.delta[mapping]), buffer + fill);
+                        fill += bytes;
+                        ++length;
+                        width = std::max(width, bytes);
+                    }
+                }
+                if (fill)
+                    result.append_bytes(buffer, fill, length, width);
+            }
+
+            // Maps the string in place up to the first character changing its size and returns
+            // the position of that character (the size of the string if there is none).
+            static std::size_t map_in_place(string & str, unsigned mapping)
+            {
+                byte_t * const strm = str.is_short() ? str.local_.bytes : str.heap_.bytes.data();
+                std::size_t const size = str.size();
+#ifdef UTF8PP_SSE2
+                __m128i const before = ascii_before(mapping), after = ascii_after(mapping);
+#endif
+                std::size_t pos = 0;
+                while (pos < size)
+                {
+#ifdef UTF8PP_SSE2
+                    if (pos + 16 <= size)
+                    {
+                        // writes other bytes back unchanged
+                        __m128i const block = _mm_loadu_si128(reinterpret_cast<__m128i const *>(strm + pos));
+                        _mm_storeu_si128(reinterpret_cast<__m128i *>(strm + pos), map_ascii(block, before, after));
+                        unsigned const mask = static_cast<unsigned>(_mm_movemask_epi8(block));
+                        unsigned const ascii = mask ? count_trailing_zeros(mask) : 16;
+                        pos += ascii;
+                        // otherwise a non ASCII character follows
+                        if (ascii == 16)
+                            continue;
+                    }
+#endif
+                    if (strm[pos] < 0xE0 && pos + 1 < size)
+                    {
+                        unsigned bytes;
+                        value_t const c = decode_narrow(strm, pos, bytes);
+                        property const & p = lookup(c);
+                        value_t const mapped = shifted(c, p.delta[mapping]);
+                        if (p.expansion[mapping] || mapped >= 0x800 || (mapped >= 0x80) != (bytes == 2))
+                            return pos;
+                        byte_t const second = strm[pos + 1];
+                        strm[pos] = static_cast<byte_t>(mapped < 0x80 ? mapped : 0xC0 | (mapped >> 6));
+                        strm[pos + 1] = bytes == 2 ? static_cast<byte_t>(0x80 | (mapped & 0x3F)) : second;
+                        pos += bytes;
+                        continue;
+                    }
+                    if (strm[pos] < 0x80)
+                    {
+                        strm[pos] = map_ascii(strm[pos], mapping);
+                        ++pos;
+                        continue;
+                    }
+
+                    std::size_t const start = pos;
+                    value_t const c = decode_valid(strm, pos);
+                    property const & p = lookup(c);
+                    if (!p.delta[mapping])
+                    {
+                        if (p.expansion[mapping])
+                            return start;
+                        continue;
+                    }
+                    value_t const mapped = shifted(c, p.delta[mapping]);
+                    if (encoded_size(mapped) != pos - start)
+                        return start;
+                    encode(mapped, strm + start);
+                }
+                return size;
+            }
+
+            static string map(string_view const & text, unsigned mapping, memory_resource * resource)
+            {
+                // validates the text
+                text.length();
+                string result(nullptr, resource);
+                result.reserve(text.size());
+                map(text.bytes(), text.size(), mapping, result);
+                return result;
+            }
+
+            static string map(string && text, unsigned mapping)
+            {
+                std::size_t const pos = map_in_place(text, mapping);
+                if (pos == text.size())
+                    return std::move(text);
+
+                string result(nullptr, text.resource());
+                result.reserve(text.size() + text.size() / 8);
+                result.append_bytes(text.bytes(), pos, utf32_length(text.bytes(), pos), max_width(text.bytes(), pos));
+                map(text.bytes() + pos, text.size() - pos, mapping, result);
+                return result;
+            }
+        };
+    }
+
+    string to_lower(string_view const & text, memory_resource * resource /* = nullptr */)
+    {
+        return detail::case_mapper::map(text, LOWER, resource);
+    }
+
+    string to_lower(char const * text, memory_resource * resource /* = nullptr */)
+    {
+        return detail::case_mapper::map(string_view(text), LOWER, resource);
+    }
+
+    string to_upper(string_view const & text, memory_resource * resource /* = nullptr */)
+    {
+        return detail::case_mapper::map(text, UPPER, resource);
+    }
+
+    string to_upper(char const * text, memory_resource * resource /* = nullptr */)
+    {
+        return detail::case_mapper::map(string_view(text), UPPER, resource);
+    }
+
+    string casefold(string_view const & text, memory_resource * resource /* = nullptr */)
+    {
+        return detail::case_mapper::map(text, FOLD, resource);
+    }
+
+    string casefold(char const * text, memory_resource * resource /* = nullptr */)
+    {
+        return detail::case_mapper::map(string_view(text), FOLD, resource);
+    }
+
+    string to_lower(string && text)
+    {
+        return detail::case_mapper::map(std::move(text), LOWER);
+    }
+
+    string to_upper(string && text)
+    {
+        return detail::case_mapper::map(std::move(text), UPPER);
+    }
+
+    string casefold(string && text)
+    {
+        return detail::case_mapper::map(std::move(text), FOLD);
+    }
+
+    bool iequals(string_view const & lhs, string_view const & rhs)
+    {
+        return !icompare(lhs, rhs);
+    }
+
+    int icompare(string_view const & lhs, string_view const & rhs)
+    {
+        // validates both texts
+        lhs.length();
+        rhs.length();
+
+        folded_reader left(lhs.bytes(), lhs.size()), right(rhs.bytes(), rhs.size());
+#ifdef UTF8PP_SSE2
+        __m128i const before = ascii_before(FOLD), after = ascii_after(FOLD);
+#endif
+        for (;;)
+        {
+#ifdef UTF8PP_SSE2
+            // the leading ASCII bytes of blocks on both sides are folded and compared at once
+            while (left.at_block() && right.at_block())
+            {
+                __m128i const a = left.block(), b = right.block();
+                unsigned const other = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(a, b)));
+                unsigned const ascii = other ? count_trailing_zeros(other) : 16;
+                unsigned const unequal = ~static_cast<unsigned>(_mm_movemask_epi8(
+                    _mm_cmpeq_epi8(map_ascii(a, before, after), map_ascii(b, before, after))));
+                if (unsigned const mask = unequal & ((1u << ascii) - 1))
+                {
+                    unsigned const n = count_trailing_zeros(mask);
+                    return map_ascii(left.byte(n), FOLD) < map_ascii(right.byte(n), FOLD) ? -1 : 1;
+                }
+                left.skip(ascii);
+                right.skip(ascii);
+                if (ascii < 16)
+                    break;
+            }
+#endif
+            value_t const a = left.next(), b = right.next();
+            if (a != b)
+                return a < b ? -1 : 1;
+            if (a == END_OF_STRING)
+                return 0;
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef UTF8PP_CORE_CASEMAPPING_HXX
+#define UTF8PP_CORE_CASEMAPPING_HXX
+
+#include "string.hxx"
+#include "string_view.hxx"
+#include "memory_resource.hxx"
+
+namespace utf8
+{
+    // The full case mappings of the Unicode character database, including the ones to several
+    // characters (the upper case of "ß" is "SS"), so the size of the result may differ.
+    // The conditional mappings of SpecialCasing.txt (final sigma, Lithuanian, Turkish and
+    // Azeri) are not applied. ASCII is mapped in blocks of 16 bytes.
+    // All functions throw an std::invalid_argument exception if the text is not valid UTF-8.
+
+    string to_lower(string_view const & text, memory_resource * resource = nullptr);
+    string to_lower(char const * text, memory_resource * resource = nullptr);
+    string to_upper(string_view const & text, memory_resource * resource = nullptr);
+    string to_upper(char const * text, memory_resource * resource = nullptr);
+    // case folding is meant for caseless matching (see also utf8::iequals())
+    string casefold(string_view const & text, memory_resource * resource = nullptr);
+    string casefold(char const * text, memory_resource * resource = nullptr);
+
+    // These rewrite the string itself as long as the characters keep their size
+    // and only copy it from the first character that doesn't.
+    string to_lower(string && text);
+    string to_upper(string && text);
+    string casefold(string && text);
+
+    // Compares the case folded texts without allocating. icompare() orders by the
+    // folded code points and returns a negative value, 0 or a positive value.
+    bool iequals(string_view const & lhs, string_view const & rhs);
+    int icompare(string_view const & lhs, string_view const & rhs);
+}
+
+#endif // UTF8PP_CORE_CASEMAPPING_HXX
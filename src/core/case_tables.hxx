@@ -0,0 +1,67 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef UTF8PP_CORE_CASETABLES_HXX
+#define UTF8PP_CORE_CASETABLES_HXX
+
+#include "types.hxx"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace utf8
+{
+    // The Unicode data used by case_mapping.cxx, generated by tools/case_tables.py.
+    namespace case_tables
+    {
+        // the mappings of a property
+        unsigned const LOWER = 0;
+        unsigned const UPPER = 1;
+        unsigned const FOLD = 2;
+
+        struct property
+        {
+            // the difference between the character and the one it maps to
+            std::int32_t delta[3];
+            // Index into expansions for characters mapping to several ones (0 otherwise).
+            // It points at the number of characters, which are following it.
+            std::uint16_t expansion[3];
+        };
+
+        // characters per block of stage2
+        std::size_t const BLOCK = 128;
+
+        // Two stage table: stage1 holds the block of every BLOCK characters,
+        // the block holds the property index of each character.
+        extern std::uint8_t const stage1[];
+        extern std::uint16_t const stage2[];
+        extern property const properties[];
+        extern char32_t const expansions[];
+
+        inline property const & lookup(value_t c)
+        {
+            return properties[stage2[stage1[c / BLOCK] * BLOCK + c % BLOCK]];
+        }
+    }
+}
+
+#endif // UTF8PP_CORE_CASETABLES_HXX
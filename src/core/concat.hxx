@@ -0,0 +1,107 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef UTF8PP_CORE_CONCAT_HXX
+#define UTF8PP_CORE_CONCAT_HXX
+
+#include "string.hxx"
+#include "string_view.hxx"
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <cstddef>
+#include <cstring>
+
+namespace utf8
+{
+    namespace detail
+    {
+        inline std::size_t concat_size(string const & part) { return part.size(); }
+        inline std::size_t concat_size(string_view const & part) { return part.size(); }
+        inline std::size_t concat_size(char const * part) { return part ? std::strlen(part) : 0; }
+        inline std::size_t concat_size(std::string const & part) { return part.size(); }
+
+        // true if the part points into the bytes of result, growing result would leave it dangling
+        // (appending a string to itself is handled by the string)
+        inline bool concat_aliases(string const & result, byte_t const * part)
+        {
+            std::less<byte_t const *> const before;
+            return !before(part, result.bytes()) && before(part, result.bytes() + result.size());
+        }
+        inline bool concat_aliases(string const &, string const &) { return false; }
+        inline bool concat_aliases(string const & result, string_view const & part) { return concat_aliases(result, part.bytes()); }
+        inline bool concat_aliases(string const & result, char const * part) { return concat_aliases(result, reinterpret_cast<byte_t const *>(part)); }
+        inline bool concat_aliases(string const &, std::string const &) { return false; }
+
+        inline void concat_append(string & result, string const & part) { result += part; }
+        inline void concat_append(string & result, string_view const & part) { result.append(part); }
+        inline void concat_append(string & result, char const * part) { result.append(string_view(part)); }
+        inline void concat_append(string & result, std::string const & part) { result.append(string_view(part)); }
+    }
+
+    // Appends utf8::strings, views, C strings and std::strings with at most one allocation
+    // (the sizes are summed up first). Parts that are not validated yet are validated while
+    // appending, this will throw an std::invalid_argument exception if one of them is invalid
+    // (the parts before it stay appended then). Views of result itself are allowed: then the
+    // parts are appended to a copy, which replaces result at the end (result stays unchanged
+    // if a part is invalid).
+    template <typename... Parts>
+    string & concat_into(string & result, Parts const &... parts)
+    {
+        std::size_t const sizes[] = { 0, detail::concat_size(parts)... };
+        std::size_t total = result.size();
+        for (std::size_t size : sizes)
+            total += size;
+
+        bool const aliases[] = { false, detail::concat_aliases(result, parts)... };
+        bool aliased = false;
+        for (bool alias : aliases)
+            aliased = aliased || alias;
+        if (aliased)
+        {
+            // the views stay valid while the copy grows
+            string copy(nullptr, result.resource());
+            copy.reserve(total);
+            copy += result;
+            int const appended[] = { 0, (detail::concat_append(copy, parts), 0)... };
+            static_cast<void>(appended);
+            result = std::move(copy);
+            return result;
+        }
+
+        result.reserve(total);
+        int const appended[] = { 0, (detail::concat_append(result, parts), 0)... };
+        static_cast<void>(appended);
+        return result;
+    }
+
+    // same as above for a new string (allocating from the default resource)
+    template <typename... Parts>
+    string concat(Parts const &... parts)
+    {
+        string result;
+        concat_into(result, parts...);
+        return result;
+    }
+}
+
+#endif // UTF8PP_CORE_CONCAT_HXX
@@ -0,0 +1,188 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "decoding.hxx"
+#include "detail.hxx"
+
+#include <type_traits>
+
+#include <cstdint>
+
+namespace
+{
+    using utf8::byte_t;
+    using utf8::value_t;
+    using utf8::detail::count_trailing_zeros;
+
+#ifdef UTF8PP_SSE2
+    std::size_t horizontal_sum(__m128i v)
+    {
+        std::uint64_t halves[2];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(halves), v);
+        return static_cast<std::size_t>(halves[0] + halves[1]);
+    }
+
+    // writes 16 ASCII characters widened to 16 or 32 bit code units
+    template <typename CodeUnit>
+    void widen(__m128i v, CodeUnit * dst, std::integral_constant<std::size_t, 2>)
+    {
+        __m128i const zero = _mm_setzero_si128();
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_unpacklo_epi8(v, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 8), _mm_unpackhi_epi8(v, zero));
+    }
+
+    template <typename CodeUnit>
+    void widen(__m128i v, CodeUnit * dst, std::integral_constant<std::size_t, 4>)
+    {
+        __m128i const zero = _mm_setzero_si128();
+        __m128i const lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 4), _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 8), _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 12), _mm_unpackhi_epi16(hi, zero));
+    }
+#endif
+
+    // number of lead bytes, and with pairs also the number of 4 byte sequences
+    std::size_t count_code_units(byte_t const * strm, std::size_t size, bool pairs)
+    {
+        std::size_t count = 0, pos = 0;
+#ifdef UTF8PP_SSE2
+        __m128i counter = _mm_setzero_si128();
+        while (pos + 16 <= size)
+        {
+            // the byte counters are flushed before they can overflow (at most 2 per block)
+            __m128i units = _mm_setzero_si128();
+            for (unsigned block = 0; block < 127 && pos + 16 <= size; ++block, pos += 16)
+            {
+                __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(strm + pos));
+                // continuation bytes are -128 to -65 as signed bytes
+                units = _mm_sub_epi8(units, _mm_cmpgt_epi8(v, _mm_set1_epi8(-65)));
+                if (pairs)
+                    units = _mm_sub_epi8(units, _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(char(0xF0))), v));
+            }
+            counter = _mm_add_epi64(counter, _mm_sad_epu8(units, _mm_setzero_si128()));
+        }
+        count = horizontal_sum(counter);
+#endif
+        for (; pos < size; ++pos)
+        {
+            count += (strm[pos] & 0xC0) != 0x80;
+            if (pairs)
+                count += strm[pos] >= 0xF0;
+        }
+        return count;
+    }
+
+    template <typename CodeUnit>
+    std::size_t decode_impl(byte_t const * strm, std::size_t size, CodeUnit * dst)
+    {
+        std::size_t pos = 0, out = 0;
+        while (pos < size)
+        {
+            byte_t const lead = strm[pos];
+            if (lead < 0x80)
+            {
+#ifdef UTF8PP_SSE2
+                if (pos + 16 <= size)
+                {
+                    __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(strm + pos));
+                    unsigned const mask = static_cast<unsigned>(_mm_movemask_epi8(v));
+                    if (!mask)
+                    {
+                        widen(v, dst + out, std::integral_constant<std::size_t, sizeof(CodeUnit)>());
+                        pos += 16;
+                        out += 16;
+                        continue;
+                    }
+
+                    // the ASCII bytes in front of the next multi byte sequence
+                    for (std::size_t end = pos + count_trailing_zeros(mask); pos < end; ++pos)
+                        dst[out++] = static_cast<CodeUnit>(strm[pos]);
+                    continue;
+                }
+#endif
+                dst[out++] = static_cast<CodeUnit>(lead);
+                ++pos;
+                continue;
+            }
+
+            value_t c;
+            if (lead < 0xE0)
+            {
+                c = (value_t(lead & 0x1F) << 6) | (strm[pos + 1] & 0x3F);
+                pos += 2;
+            }
+            else if (lead < 0xF0)
+            {
+                c = (value_t(lead & 0x0F) << 12) | (value_t(strm[pos + 1] & 0x3F) << 6) | (strm[pos + 2] & 0x3F);
+                pos += 3;
+            }
+            else
+            {
+                c = (value_t(lead & 0x07) << 18) | (value_t(strm[pos + 1] & 0x3F) << 12)
+                    | (value_t(strm[pos + 2] & 0x3F) << 6) | (strm[pos + 3] & 0x3F);
+                pos += 4;
+
+                if (sizeof(CodeUnit) == 2)
+                {
+                    // surrogate pair
+                    c -= 0x10000;
+                    dst[out++] = static_cast<CodeUnit>(0xD800 | (c >> 10));
+                    c = 0xDC00 | (c & 0x3FF);
+                }
+            }
+            dst[out++] = static_cast<CodeUnit>(c);
+        }
+        return out;
+    }
+}
+
+namespace utf8
+{
+    std::size_t utf32_length(byte_t const * strm, std::size_t size)
+    {
+        return count_code_units(strm, size, false);
+    }
+
+    std::size_t utf16_length(byte_t const * strm, std::size_t size)
+    {
+        return count_code_units(strm, size, true);
+    }
+
+    std::size_t wide_length(byte_t const * strm, std::size_t size)
+    {
+        return count_code_units(strm, size, sizeof(wchar_t) == 2);
+    }
+
+    std::size_t decode(byte_t const * strm, std::size_t size, char32_t * dst)
+    {
+        return decode_impl(strm, size, dst);
+    }
+
+    std::size_t decode(byte_t const * strm, std::size_t size, char16_t * dst)
+    {
+        return decode_impl(strm, size, dst);
+    }
+
+    std::size_t decode(byte_t const * strm, std::size_t size, wchar_t * dst)
+    {
+        return decode_impl(strm, size, dst);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef UTF8PP_CORE_DECODING_HXX
+#define UTF8PP_CORE_DECODING_HXX
+
+#include "types.hxx"
+
+#include <cstddef>
+
+namespace utf8
+{
+    // Bulk conversion of valid UTF-8 (like the bytes() of an utf8::string) into
+    // caller provided buffers. The *_length() functions return the number of code
+    // units the conversion needs, decode() writes them and returns that number.
+    // The bytes are not checked, invalid input leads to undefined behaviour.
+
+    // number of UTF-32 code units (the number of characters)
+    std::size_t utf32_length(byte_t const * strm, std::size_t size);
+    // number of UTF-16 code units (characters above U+FFFF need a surrogate pair)
+    std::size_t utf16_length(byte_t const * strm, std::size_t size);
+    // number of wchar_t code units (UTF-32 or UTF-16, depending on the size of wchar_t)
+    std::size_t wide_length(byte_t const * strm, std::size_t size);
+
+    std::size_t decode(byte_t const * strm, std::size_t size, char32_t * dst);
+    std::size_t decode(byte_t const * strm, std::size_t size, char16_t * dst);
+    std::size_t decode(byte_t const * strm, std::size_t size, wchar_t * dst);
+}
+
+#endif // UTF8PP_CORE_DECODING_HXX
@@ -0,0 +1,78 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Helpers shared by the translation units of the core library, not part of its interface.
+
+#ifndef UTF8PP_CORE_DETAIL_HXX
+#define UTF8PP_CORE_DETAIL_HXX
+
+#include "types.hxx"
+
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define UTF8PP_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace utf8
+{
+    namespace detail
+    {
+        // index of the lowest set bit (mask must not be 0)
+        inline unsigned count_trailing_zeros(unsigned mask)
+        {
+#if defined(__GNUC__)
+            return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+            unsigned n = 0;
+            while (!(mask & 1))
+                mask >>= 1, ++n;
+            return n;
+#endif
+        }
+
+        // decodes a character of valid UTF-8 and moves pos behind it
+        inline value_t decode_valid(byte_t const * strm, std::size_t & pos)
+        {
+            value_t const lead = strm[pos];
+            if (lead < 0x80)
+            {
+                ++pos;
+                return lead;
+            }
+            if (lead < 0xE0)
+            {
+                pos += 2;
+                return ((lead & 0x1F) << 6) | (strm[pos - 1] & 0x3F);
+            }
+            if (lead < 0xF0)
+            {
+                pos += 3;
+                return ((lead & 0x0F) << 12) | ((strm[pos - 2] & 0x3F) << 6) | (strm[pos - 1] & 0x3F);
+            }
+            pos += 4;
+            return ((lead & 0x07) << 18) | ((strm[pos - 3] & 0x3F) << 12) | ((strm[pos - 2] & 0x3F) << 6) | (strm[pos - 1] & 0x3F);
+        }
+    }
+}
+
+#endif // UTF8PP_CORE_DETAIL_HXX
@@ -0,0 +1,468 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "encoding.hxx"
+#include "detail.hxx"
+
+#include <stdexcept>
+
+#include <cstring>
+#include <cstdint>
+
+namespace
+{
+    void invalid_character()
+    {
+        throw std::invalid_argument("c is not a valid Unicode character.");
+    }
+
+    void unpaired_surrogate()
+    {
+        throw std::invalid_argument("String contains an unpaired surrogate.");
+    }
+
+    bool is_high_surrogate(utf8::value_t c)
+    {
+        return (c & 0xFC00) == 0xD800;
+    }
+
+    bool is_low_surrogate(utf8::value_t c)
+    {
+        return (c & 0xFC00) == 0xDC00;
+    }
+
+    template <typename CodeUnit>
+    std::size_t encoded_size_scalar(CodeUnit const * src, std::size_t size, std::size_t & length)
+    {
+        std::size_t bytes = 0;
+        for (std::size_t pos = 0; pos < size; ++pos)
+        {
+            utf8::value_t const c = static_cast<utf8::value_t>(src[pos]);
+            if (!c)
+                continue;
+
+            unsigned const charlen = utf8::detail::encoded_size(c);
+            if (!charlen)
+                invalid_character();
+            bytes += charlen;
+            ++length;
+        }
+        return bytes;
+    }
+
+    template <typename CodeUnit>
+    std::size_t encode_scalar(CodeUnit const * src, std::size_t size, utf8::byte_t * dst)
+    {
+        std::size_t out = 0;
+        for (std::size_t pos = 0; pos < size; ++pos)
+        {
+            if (src[pos])
+                out += utf8::detail::encode(static_cast<utf8::value_t>(src[pos]), dst + out);
+        }
+        return out;
+    }
+
+    // UTF-16 is sized and encoded per code unit: a high surrogate stands for the
+    // whole pair, a low surrogate for nothing, so blocks may split pairs
+    template <typename CodeUnit>
+    std::size_t encoded_size_utf16_scalar(CodeUnit const * src, std::size_t begin, std::size_t size, std::size_t & length)
+    {
+        std::size_t bytes = 0;
+        for (std::size_t pos = begin; pos < size; ++pos)
+        {
+            utf8::value_t const c = static_cast<std::uint16_t>(src[pos]);
+            if (!c)
+                continue;
+
+            if (is_high_surrogate(c))
+            {
+                if (pos + 1 == size || !is_low_surrogate(static_cast<std::uint16_t>(src[pos + 1])))
+                    unpaired_surrogate();
+                bytes += 4;
+            }
+            else if (is_low_surrogate(c))
+            {
+                if (!pos || !is_high_surrogate(static_cast<std::uint16_t>(src[pos - 1])))
+                    unpaired_surrogate();
+                continue;
+            }
+            else
+                bytes += utf8::detail::encoded_size(c);
+            ++length;
+        }
+        return bytes;
+    }
+
+    // encodes the code units [begin, end), a high surrogate at end - 1 reads its partner behind end
+    template <typename CodeUnit>
+    std::size_t encode_utf16_scalar(CodeUnit const * src, std::size_t begin, std::size_t end, utf8::byte_t * dst)
+    {
+        std::size_t out = 0;
+        for (std::size_t pos = begin; pos < end; ++pos)
+        {
+            utf8::value_t c = static_cast<std::uint16_t>(src[pos]);
+            if (!c || is_low_surrogate(c))
+                continue;
+            if (is_high_surrogate(c))
+                c = 0x10000 + (((c & 0x3FF) << 10) | (static_cast<std::uint16_t>(src[pos + 1]) & 0x3FF));
+            out += utf8::detail::encode(c, dst + out);
+        }
+        return out;
+    }
+
+#ifdef UTF8PP_SSE2
+    // sums up the 32 bit lanes
+    std::size_t horizontal_sum(__m128i v)
+    {
+        std::uint32_t lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), v);
+        return std::size_t(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    // negated sum of the signed 16 bit lanes (the counters are sums of -1 masks)
+    std::size_t horizontal_negative_sum(__m128i v)
+    {
+        std::int32_t lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), _mm_madd_epi16(v, _mm_set1_epi16(-1)));
+        return static_cast<std::size_t>(std::int64_t(lanes[0]) + lanes[1] + lanes[2] + lanes[3]);
+    }
+
+    // The SSE2 kernels expect 32 bit code units.
+
+    // 4 characters at a time: every character needs 1 byte plus one for each
+    // of the limits 0x80, 0x800 and 0x10000 it reaches
+    template <typename CodeUnit>
+    std::size_t encoded_size_sse2(CodeUnit const * src, std::size_t size, std::size_t & length)
+    {
+        __m128i const zero = _mm_setzero_si128();
+        std::size_t bytes = 0, pos = 0, nuls = 0;
+        __m128i invalid = zero;
+
+        while (pos + 4 <= size)
+        {
+            // the lane counters are flushed before they can overflow
+            __m128i extra = zero, nul = zero;
+            for (unsigned block = 0; block < 0x10000 && pos + 4 <= size; ++block, pos += 4)
+            {
+                __m128i const c = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + pos));
+                extra = _mm_sub_epi32(extra, _mm_cmpgt_epi32(c, _mm_set1_epi32(0x7F)));
+                extra = _mm_sub_epi32(extra, _mm_cmpgt_epi32(c, _mm_set1_epi32(0x7FF)));
+                extra = _mm_sub_epi32(extra, _mm_cmpgt_epi32(c, _mm_set1_epi32(0xFFFF)));
+                nul = _mm_sub_epi32(nul, _mm_cmpeq_epi32(c, zero));
+
+                // above U+10FFFF (unsigned) or surrogate
+                invalid = _mm_or_si128(invalid, _mm_cmpgt_epi32(_mm_srli_epi32(c, 16), _mm_set1_epi32(0x10)));
+                invalid = _mm_or_si128(invalid, _mm_cmpeq_epi32(
+                    _mm_and_si128(c, _mm_set1_epi32(static_cast<int>(0xFFFFF800))), _mm_set1_epi32(0xD800)));
+            }
+            bytes += horizontal_sum(extra);
+            nuls += horizontal_sum(nul);
+        }
+
+        if (_mm_movemask_epi8(invalid))
+            invalid_character();
+
+        // NULL characters are skipped
+        bytes += pos - nuls;
+        length += pos - nuls;
+        return bytes + encoded_size_scalar(src + pos, size - pos, length);
+    }
+
+    // ASCII and two byte runs are converted in blocks, everything else character by character
+    template <typename CodeUnit>
+    std::size_t encode_sse2(CodeUnit const * src, std::size_t size, utf8::byte_t * dst)
+    {
+        __m128i const zero = _mm_setzero_si128();
+        std::size_t out = 0, pos = 0;
+
+        while (pos + 4 <= size)
+        {
+            if (pos + 16 <= size)
+            {
+                __m128i const a = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + pos));
+                __m128i const b = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + pos + 4));
+                __m128i const c = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + pos + 8));
+                __m128i const d = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + pos + 12));
+                __m128i const any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+                __m128i const nul = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi32(a, zero), _mm_cmpeq_epi32(b, zero)),
+                    _mm_or_si128(_mm_cmpeq_epi32(c, zero), _mm_cmpeq_epi32(d, zero)));
+                __m128i const high = _mm_and_si128(any, _mm_set1_epi32(static_cast<int>(0xFFFFFF80)));
+
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(high, zero)) == 0xFFFF && !_mm_movemask_epi8(nul))
+                {
+                    // 16 ASCII characters: narrow 32 -> 16 -> 8 bits
+                    __m128i const packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + out), packed);
+                    pos += 16;
+                    out += 16;
+                    continue;
+                }
+            }
+
+            __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + pos));
+            __m128i const two_bytes = _mm_and_si128(
+                _mm_cmpgt_epi32(v, _mm_set1_epi32(0x7F)), _mm_cmplt_epi32(v, _mm_set1_epi32(0x800)));
+            if (_mm_movemask_epi8(two_bytes) == 0xFFFF)
+            {
+                // 4 characters U+0080 - U+07FF: 110xxxxx 10xxxxxx
+                __m128i const lead = _mm_or_si128(_mm_srli_epi32(v, 6), _mm_set1_epi32(0xC0));
+                __m128i const trail = _mm_or_si128(_mm_and_si128(v, _mm_set1_epi32(0x3F)), _mm_set1_epi32(0x80));
+                __m128i words = _mm_or_si128(lead, _mm_slli_epi32(trail, 8));
+                // sign extend, so the signed saturation keeps the 16 bit values
+                words = _mm_srai_epi32(_mm_slli_epi32(words, 16), 16);
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + out), _mm_packs_epi32(words, words));
+                pos += 4;
+                out += 8;
+                continue;
+            }
+
+            out += encode_scalar(src + pos, 4, dst + out);
+            pos += 4;
+        }
+        return out + encode_scalar(src + pos, size - pos, dst + out);
+    }
+
+    // The UTF-16 kernels expect 16 bit code units.
+
+    // 8 code units at a time: every unit needs 3 bytes, minus one below 0x800 and another one
+    // below 0x80, NULL characters and low surrogates need none, high surrogates 4
+    template <typename CodeUnit>
+    std::size_t encoded_size_utf16_sse2(CodeUnit const * src, std::size_t size, std::size_t & length)
+    {
+        // a low surrogate at the start has no partner
+        if (size && is_low_surrogate(static_cast<std::uint16_t>(src[0])))
+            unpaired_surrogate();
+
+        __m128i const zero = _mm_setzero_si128();
+        __m128i const high_bits = _mm_set1_epi16(static_cast<short>(0xFC00));
+        std::size_t bytes = 0, pos = 0;
+        __m128i invalid = zero;
+
+        // the unit behind each block is loaded as well to check the pairs
+        while (pos + 9 <= size)
+        {
+            // the lane counters are flushed before they can overflow
+            std::size_t const start = pos;
+            __m128i extra = zero, missing = zero;
+            for (unsigned block = 0; block < 0x1000 && pos + 9 <= size; ++block, pos += 8)
+            {
+                __m128i const c = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + pos));
+                __m128i const next = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + pos + 1));
+                __m128i const nul = _mm_cmpeq_epi16(c, zero);
+                __m128i const high = _mm_cmpeq_epi16(_mm_and_si128(c, high_bits), _mm_set1_epi16(static_cast<short>(0xD800)));
+                __m128i const low = _mm_cmpeq_epi16(_mm_and_si128(c, high_bits), _mm_set1_epi16(static_cast<short>(0xDC00)));
+
+                // every high surrogate is followed by a low one and every low one follows a high one
+                invalid = _mm_or_si128(invalid, _mm_xor_si128(high, _mm_cmpeq_epi16(
+                    _mm_and_si128(next, high_bits), _mm_set1_epi16(static_cast<short>(0xDC00)))));
+
+                // the masks are -1 where they apply
+                extra = _mm_add_epi16(extra, _mm_cmpeq_epi16(_mm_and_si128(c, _mm_set1_epi16(static_cast<short>(0xFF80))), zero));
+                extra = _mm_add_epi16(extra, _mm_cmpeq_epi16(_mm_and_si128(c, _mm_set1_epi16(static_cast<short>(0xF800))), zero));
+                extra = _mm_sub_epi16(_mm_add_epi16(extra, nul), high);
+                extra = _mm_add_epi16(extra, _mm_add_epi16(low, _mm_add_epi16(low, low)));
+                missing = _mm_add_epi16(missing, _mm_add_epi16(nul, low));
+            }
+
+            std::size_t const units = pos - start;
+            bytes += 3 * units - horizontal_negative_sum(extra);
+            length += units - horizontal_negative_sum(missing);
+        }
+
+        if (_mm_movemask_epi8(invalid))
+            unpaired_surrogate();
+
+        return bytes + encoded_size_utf16_scalar(src, pos, size, length);
+    }
+
+    // ASCII and two byte runs are converted in blocks of 8, everything else unit by unit
+    template <typename CodeUnit>
+    std::size_t encode_utf16_sse2(CodeUnit const * src, std::size_t size, utf8::byte_t * dst)
+    {
+        __m128i const zero = _mm_setzero_si128();
+        std::size_t out = 0, pos = 0;
+
+        for (; pos + 8 <= size; pos += 8)
+        {
+            __m128i const c = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + pos));
+            __m128i const ascii = _mm_cmpeq_epi16(_mm_and_si128(c, _mm_set1_epi16(static_cast<short>(0xFF80))), zero);
+            __m128i const nul = _mm_cmpeq_epi16(c, zero);
+            if (_mm_movemask_epi8(ascii) == 0xFFFF && !_mm_movemask_epi8(nul))
+            {
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + out), _mm_packus_epi16(c, c));
+                out += 8;
+                continue;
+            }
+
+            __m128i const short_units = _mm_cmpeq_epi16(_mm_and_si128(c, _mm_set1_epi16(static_cast<short>(0xF800))), zero);
+            if (_mm_movemask_epi8(_mm_andnot_si128(ascii, short_units)) == 0xFFFF)
+            {
+                // 8 characters U+0080 - U+07FF: 110xxxxx 10xxxxxx
+                __m128i const lead = _mm_or_si128(_mm_srli_epi16(c, 6), _mm_set1_epi16(0xC0));
+                __m128i const trail = _mm_or_si128(_mm_and_si128(c, _mm_set1_epi16(0x3F)), _mm_set1_epi16(0x80));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + out), _mm_or_si128(lead, _mm_slli_epi16(trail, 8)));
+                out += 16;
+                continue;
+            }
+
+            out += encode_utf16_scalar(src, pos, pos + 8, dst + out);
+        }
+        return out + encode_utf16_scalar(src, pos, size, dst + out);
+    }
+#endif
+
+    template <typename CodeUnit>
+    std::size_t encoded_size_utf32(CodeUnit const * src, std::size_t size, std::size_t & length)
+    {
+#ifdef UTF8PP_SSE2
+        if (sizeof(CodeUnit) == 4)
+            return encoded_size_sse2(src, size, length);
+#endif
+        return encoded_size_scalar(src, size, length);
+    }
+
+    template <typename CodeUnit>
+    std::size_t encode_utf32(CodeUnit const * src, std::size_t size, utf8::byte_t * dst)
+    {
+#ifdef UTF8PP_SSE2
+        if (sizeof(CodeUnit) == 4)
+            return encode_sse2(src, size, dst);
+#endif
+        return encode_scalar(src, size, dst);
+    }
+
+    template <typename CodeUnit>
+    std::size_t encoded_size_utf16(CodeUnit const * src, std::size_t size, std::size_t & length)
+    {
+#ifdef UTF8PP_SSE2
+        if (sizeof(CodeUnit) == 2)
+            return encoded_size_utf16_sse2(src, size, length);
+#endif
+        return encoded_size_utf16_scalar(src, 0, size, length);
+    }
+
+    template <typename CodeUnit>
+    std::size_t encode_utf16(CodeUnit const * src, std::size_t size, utf8::byte_t * dst)
+    {
+#ifdef UTF8PP_SSE2
+        if (sizeof(CodeUnit) == 2)
+            return encode_utf16_sse2(src, size, dst);
+#endif
+        return encode_utf16_scalar(src, 0, size, dst);
+    }
+}
+
+namespace utf8
+{
+    namespace detail
+    {
+        unsigned encoded_size(value_t c)
+        {
+            if (c < 0x80)
+                return 1;
+            if (c < 0x800)
+                return 2;
+            if (c < 0x10000)
+                return (c >= 0xD800 && c <= 0xDFFF) ? 0 : 3;
+            if (c <= 0x10FFFF)
+                return 4;
+            return 0;
+        }
+
+        unsigned encode(value_t c, byte_t * out)
+        {
+            if (c < 0x80)
+            {
+                out[0] = static_cast<byte_t>(c);
+                return 1;
+            }
+            if (c < 0x800)
+            {
+                out[0] = static_cast<byte_t>(0xC0 | (c >> 6));
+                out[1] = static_cast<byte_t>(0x80 | (c & 0x3F));
+                return 2;
+            }
+            if (c < 0x10000)
+            {
+                out[0] = static_cast<byte_t>(0xE0 | (c >> 12));
+                out[1] = static_cast<byte_t>(0x80 | ((c >> 6) & 0x3F));
+                out[2] = static_cast<byte_t>(0x80 | (c & 0x3F));
+                return 3;
+            }
+            out[0] = static_cast<byte_t>(0xF0 | (c >> 18));
+            out[1] = static_cast<byte_t>(0x80 | ((c >> 12) & 0x3F));
+            out[2] = static_cast<byte_t>(0x80 | ((c >> 6) & 0x3F));
+            out[3] = static_cast<byte_t>(0x80 | (c & 0x3F));
+            return 4;
+        }
+
+        std::size_t encoded_size(char32_t const * src, std::size_t size, std::size_t & length)
+        {
+            return encoded_size_utf32(src, size, length);
+        }
+
+        std::size_t encoded_size(char16_t const * src, std::size_t size, std::size_t & length)
+        {
+            return encoded_size_utf16(src, size, length);
+        }
+
+        std::size_t encoded_size(wchar_t const * src, std::size_t size, std::size_t & length)
+        {
+            if (sizeof(wchar_t) == 2)
+                return encoded_size_utf16(src, size, length);
+            return encoded_size_utf32(src, size, length);
+        }
+
+        std::size_t encode(char32_t const * src, std::size_t size, byte_t * dst)
+        {
+            return encode_utf32(src, size, dst);
+        }
+
+        std::size_t encode(char16_t const * src, std::size_t size, byte_t * dst)
+        {
+            return encode_utf16(src, size, dst);
+        }
+
+        std::size_t encode(wchar_t const * src, std::size_t size, byte_t * dst)
+        {
+            if (sizeof(wchar_t) == 2)
+                return encode_utf16(src, size, dst);
+            return encode_utf32(src, size, dst);
+        }
+    }
+
+    std::size_t utf8_size(char16_t const * src, std::size_t size)
+    {
+        std::size_t length = 0;
+        return detail::encoded_size(src, size, length);
+    }
+
+    std::size_t utf8_size(char32_t const * src, std::size_t size)
+    {
+        std::size_t length = 0;
+        return detail::encoded_size(src, size, length);
+    }
+
+    std::size_t utf8_size(wchar_t const * src, std::size_t size)
+    {
+        std::size_t length = 0;
+        return detail::encoded_size(src, size, length);
+    }
+}
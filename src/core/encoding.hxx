@@ -0,0 +1,61 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef UTF8PP_CORE_ENCODING_HXX
+#define UTF8PP_CORE_ENCODING_HXX
+
+#include "types.hxx"
+
+#include <cstddef>
+
+namespace utf8
+{
+    namespace detail
+    {
+        // number of bytes of the UTF-8 encoding of c (0 if c is not a valid Unicode character)
+        unsigned encoded_size(value_t c);
+        // writes the UTF-8 encoding of a valid character and returns the number of bytes written
+        unsigned encode(value_t c, byte_t * out);
+
+        // Number of UTF-8 bytes needed for a buffer of UTF-32 or UTF-16 code units, the number
+        // of characters is stored in length. NULL characters are skipped, because utf8::string
+        // can't contain them. This will throw an std::invalid_argument exception if a UTF-32
+        // buffer contains surrogates or values above U+10FFFF, or if a UTF-16 buffer contains
+        // unpaired surrogates.
+        // The wchar_t overloads use UTF-16 for 2 byte and UTF-32 for 4 byte wchar_t.
+        std::size_t encoded_size(char32_t const * src, std::size_t size, std::size_t & length);
+        std::size_t encoded_size(char16_t const * src, std::size_t size, std::size_t & length);
+        std::size_t encoded_size(wchar_t const * src, std::size_t size, std::size_t & length);
+
+        // encodes a buffer checked by encoded_size() and returns the number of bytes written
+        std::size_t encode(char32_t const * src, std::size_t size, byte_t * dst);
+        std::size_t encode(char16_t const * src, std::size_t size, byte_t * dst);
+        std::size_t encode(wchar_t const * src, std::size_t size, byte_t * dst);
+    }
+
+    // Dry run of the conversion to UTF-8: the number of bytes utf8::string::append() needs
+    // for the buffer (without NULL characters). Throws like detail::encoded_size().
+    std::size_t utf8_size(char16_t const * src, std::size_t size);
+    std::size_t utf8_size(char32_t const * src, std::size_t size);
+    std::size_t utf8_size(wchar_t const * src, std::size_t size);
+}
+
+#endif // UTF8PP_CORE_ENCODING_HXX
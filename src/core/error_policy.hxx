@@ -0,0 +1,65 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef UTF8PP_CORE_ERRORPOLICY_HXX
+#define UTF8PP_CORE_ERRORPOLICY_HXX
+
+#include <cstddef>
+
+namespace utf8
+{
+    // Tags selecting how utf8::string treats invalid input instead of throwing:
+    //   replace_invalid - every maximal subpart of an ill-formed sequence (and every NULL byte)
+    //                     becomes U+FFFD
+    //   skip_invalid    - ill-formed sequences and NULL bytes are dropped
+    // Passing a check_result instead selects the checked mode: nothing is copied unless
+    // the whole input is valid and the result tells where the first error is.
+    struct replace_invalid_t {};
+    struct skip_invalid_t {};
+
+    static replace_invalid_t const replace_invalid = {};
+    static skip_invalid_t const skip_invalid = {};
+
+    // the outcome of a checked construction
+    struct check_result
+    {
+        enum class error
+        {
+            none,
+            // the input contains a malformed sequence or a NULL byte
+            invalid,
+            // the memory resource failed to allocate
+            no_memory
+        };
+
+        error status;
+        // byte offset of the first invalid byte (the size of the input if there is none)
+        std::size_t offset;
+
+        explicit operator bool () const
+        {
+            return status == error::none;
+        }
+    };
+}
+
+#endif // UTF8PP_CORE_ERRORPOLICY_HXX
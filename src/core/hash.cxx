@@ -0,0 +1,90 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "hash.hxx"
+
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+    std::uint64_t const PRIME1 = UINT64_C(0x9E3779B185EBCA87);
+    std::uint64_t const PRIME2 = UINT64_C(0xC2B2AE3D27D4EB4F);
+
+    std::uint64_t load(utf8::byte_t const * strm)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, strm, sizeof(word));
+        return word;
+    }
+
+    std::uint64_t rotate(std::uint64_t value, unsigned bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    std::uint64_t round(std::uint64_t hash, std::uint64_t word)
+    {
+        return rotate(hash ^ (word * PRIME2), 31) * PRIME1;
+    }
+
+    // the finalizer of MurmurHash3, spreads every bit over the whole value
+    std::uint64_t finish(std::uint64_t hash)
+    {
+        hash ^= hash >> 33;
+        hash *= UINT64_C(0xFF51AFD7ED558CCD);
+        hash ^= hash >> 33;
+        hash *= UINT64_C(0xC4CEB9FE1A85EC53);
+        hash ^= hash >> 33;
+        return hash;
+    }
+}
+
+namespace utf8
+{
+    namespace detail
+    {
+        std::size_t hash_bytes(byte_t const * strm, std::size_t size)
+        {
+            // two independent lanes keep both multipliers busy
+            std::uint64_t first = PRIME1 ^ size, second = PRIME2;
+            std::size_t pos = 0;
+            for (; pos + 16 <= size; pos += 16)
+            {
+                first = round(first, load(strm + pos));
+                second = round(second, load(strm + pos + 8));
+            }
+            if (pos + 8 <= size)
+            {
+                first = round(first, load(strm + pos));
+                pos += 8;
+            }
+
+            // the remaining bytes are padded with zeros (the size is part of the hash)
+            std::uint64_t tail = 0;
+            if (pos < size)
+            {
+                std::memcpy(&tail, strm + pos, size - pos);
+                second = round(second, tail);
+            }
+
+            return static_cast<std::size_t>(finish(first ^ rotate(second, 17)));
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef UTF8PP_CORE_HASH_HXX
+#define UTF8PP_CORE_HASH_HXX
+
+#include "types.hxx"
+
+#include <cstddef>
+
+namespace utf8
+{
+    namespace detail
+    {
+        // Hash of a byte stream, eight bytes at a time. Strings and views with
+        // the same bytes hash the same, so they can be looked up with each other.
+        // (not meant to withstand collision attacks)
+        std::size_t hash_bytes(byte_t const * strm, std::size_t size);
+    }
+}
+
+#endif // UTF8PP_CORE_HASH_HXX
@@ -0,0 +1,212 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "intern_pool.hxx"
+#include "hash.hxx"
+
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include <cstring>
+
+namespace
+{
+    utf8::string const EMPTY;
+
+    std::size_t const MAX_SHARDS = 256;
+    // the shard is selected by the highest bits of the hash, the slot by the lowest ones
+    unsigned const SHARD_SHIFT = sizeof(std::size_t) * 8 - 8;
+}
+
+namespace utf8
+{
+    interned::interned()
+        : entry_(nullptr)
+    {
+    }
+
+    interned::interned(entry const * entry)
+        : entry_(entry)
+    {
+    }
+
+    string const & interned::str() const
+    {
+        return entry_ ? entry_->value : EMPTY;
+    }
+
+    interned::operator string_view () const
+    {
+        return string_view(str());
+    }
+
+    byte_t const * interned::bytes() const
+    {
+        return str().bytes();
+    }
+
+    std::size_t interned::size() const
+    {
+        return str().size();
+    }
+
+    std::size_t interned::length() const
+    {
+        return str().length();
+    }
+
+    bool interned::empty() const
+    {
+        return !str().size();
+    }
+
+    std::size_t interned::hash() const
+    {
+        return entry_ ? entry_->hash : detail::hash_bytes(nullptr, 0);
+    }
+
+    bool interned::operator == (interned const & rhs) const
+    {
+        return entry_ == rhs.entry_;
+    }
+
+    bool interned::operator != (interned const & rhs) const
+    {
+        return entry_ != rhs.entry_;
+    }
+
+    struct intern_pool::shard
+    {
+        shard()
+            : count(0)
+        {
+        }
+
+        std::mutex lock;
+        // open addressing with linear probing, at most half of the slots are used
+        std::vector<entry *> slots;
+        std::size_t count;
+
+        // the slot of the equal string or the empty slot where it belongs
+        entry * & slot(std::size_t hash, byte_t const * strm, std::size_t size)
+        {
+            std::size_t const mask = slots.size() - 1;
+            for (std::size_t index = hash & mask; ; index = (index + 1) & mask)
+            {
+                entry * & candidate = slots[index];
+                if (!candidate || (candidate->hash == hash && candidate->value.size() == size
+                    && !std::memcmp(candidate->value.bytes(), strm, size)))
+                    return candidate;
+            }
+        }
+
+        void rehash(std::size_t capacity)
+        {
+            std::vector<entry *> old(capacity, nullptr);
+            old.swap(slots);
+            for (entry * e : old)
+            {
+                if (e)
+                    slot(e->hash, e->value.bytes(), e->value.size()) = e;
+            }
+        }
+    };
+
+    intern_pool::intern_pool(unsigned shards /* = 16 */, memory_resource * resource /* = nullptr */)
+        : resource_(resource_or_default(resource))
+        , mask_(1)
+    {
+        std::size_t const wanted = std::min<std::size_t>(std::max(shards, 1u), MAX_SHARDS);
+        while (mask_ < wanted)
+            mask_ <<= 1;
+        shards_.reset(new shard[mask_]);
+        --mask_;
+    }
+
+    intern_pool::~intern_pool()
+    {
+        for (std::size_t n = 0; n <= mask_; ++n)
+        {
+            for (entry * e : shards_[n].slots)
+            {
+                if (e)
+                {
+                    e->~entry();
+                    resource_->deallocate(e, sizeof(entry), alignof(entry));
+                }
+            }
+        }
+    }
+
+    intern_pool::shard & intern_pool::shard_of(std::size_t hash) const
+    {
+        return shards_[(hash >> SHARD_SHIFT) & mask_];
+    }
+
+    interned intern_pool::intern(string_view const & str)
+    {
+        // validates the view
+        str.length();
+
+        std::size_t const hash = detail::hash_bytes(str.bytes(), str.size());
+        shard & s = shard_of(hash);
+        std::lock_guard<std::mutex> guard(s.lock);
+
+        if ((s.count + 1) * 2 > s.slots.size())
+            s.rehash(std::max<std::size_t>(16, s.slots.size() * 2));
+
+        entry * & slot = s.slot(hash, str.bytes(), str.size());
+        if (!slot)
+        {
+            void * const memory = resource_->allocate(sizeof(entry), alignof(entry));
+            try
+            {
+                slot = new (memory) entry{ hash, string(str, resource_) };
+            }
+            catch (...)
+            {
+                resource_->deallocate(memory, sizeof(entry), alignof(entry));
+                throw;
+            }
+            ++s.count;
+        }
+        return interned(slot);
+    }
+
+    interned intern_pool::find(string_view const & str) const
+    {
+        std::size_t const hash = detail::hash_bytes(str.bytes(), str.size());
+        shard & s = shard_of(hash);
+        std::lock_guard<std::mutex> guard(s.lock);
+        return s.slots.empty() ? interned() : interned(s.slot(hash, str.bytes(), str.size()));
+    }
+
+    std::size_t intern_pool::size() const
+    {
+        std::size_t total = 0;
+        for (std::size_t n = 0; n <= mask_; ++n)
+        {
+            std::lock_guard<std::mutex> guard(shards_[n].lock);
+            total += shards_[n].count;
+        }
+        return total;
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef UTF8PP_CORE_INTERNPOOL_HXX
+#define UTF8PP_CORE_INTERNPOOL_HXX
+
+#include "types.hxx"
+#include "string.hxx"
+#include "string_view.hxx"
+#include "memory_resource.hxx"
+
+#include <functional>
+#include <memory>
+#include <cstddef>
+
+namespace utf8
+{
+    class intern_pool;
+
+    // A handle of a string stored in an intern_pool. Handles of equal strings from the
+    // same pool refer to the same storage, so they are compared by address.
+    // The hash is computed once when the string is interned.
+    // Handles stay valid until the pool is destroyed.
+    class interned
+    {
+    public:
+        // the empty handle (not part of any pool)
+        interned();
+
+        // the interned string (empty for the empty handle)
+        string const & str() const;
+        operator string_view () const;
+        byte_t const * bytes() const;
+        std::size_t size() const;
+        std::size_t length() const;
+        bool empty() const;
+        // the cached std::hash<utf8::string> value
+        std::size_t hash() const;
+
+        // only meaningful for handles of the same pool
+        bool operator == (interned const & rhs) const;
+        bool operator != (interned const & rhs) const;
+
+    private:
+        struct entry
+        {
+            std::size_t hash;
+            string value;
+        };
+
+        explicit interned(entry const * entry);
+
+        entry const * entry_;
+
+        friend class intern_pool;
+    };
+
+    // A thread safe table of deduplicated strings. The table is split into shards,
+    // each guarded by its own mutex, so concurrent interning rarely waits.
+    // The strings are never removed; they allocate from the given resource.
+    class intern_pool
+    {
+    public:
+        // the number of shards is rounded up to a power of two (at most 256)
+        explicit intern_pool(unsigned shards = 16, memory_resource * resource = nullptr);
+        ~intern_pool();
+
+        intern_pool(intern_pool const &) = delete;
+        intern_pool & operator = (intern_pool const &) = delete;
+
+        // Returns the handle of the equal string, adding a copy of it first if needed.
+        // Views are validated, this will throw an std::invalid_argument exception if they are invalid.
+        interned intern(string_view const & str);
+
+        // the handle of the equal string or the empty handle if it has not been interned
+        interned find(string_view const & str) const;
+
+        // number of distinct strings
+        std::size_t size() const;
+
+    private:
+        typedef interned::entry entry;
+        struct shard;
+
+        shard & shard_of(std::size_t hash) const;
+
+        memory_resource * resource_;
+        std::size_t mask_;
+        std::unique_ptr<shard[]> shards_;
+    };
+}
+
+namespace std
+{
+    // the cached hash of the string
+    template <>
+    struct hash<utf8::interned>
+    {
+        std::size_t operator () (utf8::interned const & handle) const
+        {
+            return handle.hash();
+        }
+    };
+}
+
+#endif // UTF8PP_CORE_INTERNPOOL_HXX
@@ -22,70 +22,33 @@
 
 namespace
 {
-    // calculates the next UTF-8 character of the input byte stream
+    // byte length of the character starting with the given lead byte
     // unsafe version -> expects string to be valid
-    utf8::value_t next(utf8::byte_t const * & strm, unsigned & length)
+    unsigned sequence_length(utf8::byte_t lead)
     {
-        // end of string
-        if (!length)
-            return utf8::END_OF_STRING;
-
-        utf8::value_t result;
-        unsigned charlen;
-
-        // single byte character
-        if (!(strm[0] & 0x80))
-        {
-            charlen = 1;
-            result = strm[0] & 0x7F;
-        }
-        else
-        {
-            utf8::byte_t mask;
-            // determine the byte length of the character
-            if ((strm[0] & 0xE0) == 0xC0)
-                charlen = 2, mask = 0x1F;
-            else if ((strm[0] & 0xF0) == 0xE0)
-                charlen = 3, mask = 0x0F;
-            else if ((strm[0] & 0xF8) == 0xF0)
-                charlen = 4, mask = 0x07;
-
-            // calculate the unicode index
-            result = strm[0] & mask;
-            for (unsigned byte = 1; byte < charlen; ++byte)
-            {
-                utf8::byte_t cb = strm[byte];
-                result = (result << 6) | (cb & 0x3F);
-            }
-        }
-        // increment ptr and decrement len
-        strm += charlen;
-        length -= charlen;
-
-        return result;
+        // indexed by the high nibble (continuation bytes never start a character)
+        static unsigned char const lengths[16] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 3, 4 };
+        return lengths[lead >> 4];
     }
 
-    utf8::value_t fast_foward(utf8::byte_t const * & strm, unsigned & length, unsigned offset)
+    // decodes the UTF-8 character at strm
+    utf8::value_t decode(utf8::byte_t const * strm)
     {
-        if (!offset)
-            return utf8::INVALID_CHARACTER;
+        // single byte character
+        if (!(strm[0] & 0x80))
+            return strm[0];
 
-        for (unsigned n = 0; n < offset; ++n)
+        // calculate the unicode index
+        switch (sequence_length(strm[0]))
         {
-            unsigned step = 0;
-            if (!(strm[0] & 0x80))
-                step = 1;
-            else if ((strm[0] & 0xE0) == 0xC0)
-                step = 2;
-            else if ((strm[0] & 0xF0) == 0xE0)
-                step = 3;
-            else if ((strm[0] & 0xF8) == 0xF0)
-                step = 4;
-            else if (strm[0] == 0)
-                return utf8::END_OF_STRING;
-            strm += step; length -= step;
+        case 2:
+            return (utf8::value_t(strm[0] & 0x1F) << 6) | (strm[1] & 0x3F);
+        case 3:
+            return (utf8::value_t(strm[0] & 0x0F) << 12) | (utf8::value_t(strm[1] & 0x3F) << 6) | (strm[2] & 0x3F);
+        default:
+            return (utf8::value_t(strm[0] & 0x07) << 18) | (utf8::value_t(strm[1] & 0x3F) << 12)
+                | (utf8::value_t(strm[2] & 0x3F) << 6) | (strm[3] & 0x3F);
         }
-        return next(strm, length);
     }
 }
 
@@ -94,9 +57,11 @@ namespace utf8
     namespace detail
     {
         iterator::iterator()
-            : strm_(nullptr)
-            , length_(0)
-            , value_(INVALID_CHARACTER)
+            : begin_(nullptr)
+            , end_(nullptr)
+            , strm_(nullptr)
+            , owner_(nullptr)
+            , position_(0)
         {
         }
 
@@ -104,13 +69,13 @@ namespace utf8
         iterator::iterator(iterator const & src) = default;
         iterator & iterator::operator = (iterator const & src) = default;
 
-        iterator::iterator(byte_t const * strm, unsigned length)
-            : strm_(strm)
-            , length_(length)
-            , value_(next(strm, length))
+        iterator::iterator(string const * owner, byte_t const * begin, byte_t const * end, byte_t const * strm, std::size_t position)
+            : begin_(begin)
+            , end_(end)
+            , strm_(strm)
+            , owner_(owner)
+            , position_(position)
         {
-            if (value_ == END_OF_STRING)
-                strm_ = nullptr;
         }
 
         bool iterator::operator == (iterator const & rhs) const
@@ -127,27 +92,47 @@ namespace utf8
         iterator iterator::operator ++ (int)
         {
             iterator tmp(*this);
-            value_ = next(strm_, length_);
-
-            if (value_ == END_OF_STRING)
-                strm_ = nullptr;
-
+            ++*this;
             return tmp;
         }
 
         iterator & iterator::operator ++ ()
         {
-            value_ = next(strm_, length_);
+            strm_ += sequence_length(*strm_);
+            ++position_;
+            return *this;
+        }
 
-            if (value_ == END_OF_STRING)
-                strm_ = nullptr;
+        iterator iterator::operator -- (int)
+        {
+            iterator tmp(*this);
+            --*this;
+            return tmp;
+        }
 
+        iterator & iterator::operator -- ()
+        {
+            // step back over the continuation bytes to the lead byte
+            do
+                --strm_;
+            while ((*strm_ & 0xC0) == 0x80);
+            --position_;
             return *this;
         }
 
-        value_t const & iterator::operator * () const
+        value_t iterator::operator * () const
         {
-            return value_;
+            return strm_ == end_ ? END_OF_STRING : decode(strm_);
+        }
+
+        std::size_t iterator::offset() const
+        {
+            return static_cast<std::size_t>(strm_ - begin_);
+        }
+
+        std::size_t iterator::position() const
+        {
+            return position_;
         }
 
         iterator iterator::operator + (unsigned offset) const
@@ -159,13 +144,23 @@ namespace utf8
 
         iterator & iterator::operator += (unsigned offset)
         {
-            value_t tmp = fast_foward(strm_, length_, offset);
-            if (tmp != INVALID_CHARACTER)
-                value_ = tmp;
-
-            if (value_ == END_OF_STRING)
-                strm_ = nullptr;
+            // long jumps start at the closest checkpoint of the offset index,
+            // in ASCII strings every jump is a direct one
+            if (owner_ && (offset > offset_index::STRIDE || owner_->is_ascii()))
+            {
+                position_ += offset;
+                if (position_ >= owner_->length())
+                {
+                    strm_ = end_;
+                    position_ = owner_->length();
+                }
+                else
+                    strm_ = begin_ + owner_->offset(position_);
+                return *this;
+            }
 
+            for (; offset && strm_ != end_; --offset)
+                ++*this;
             return *this;
         }
     }
@@ -24,15 +24,28 @@
 
 #include "types.hxx"
 
+#include <iterator>
+
+#include <cstddef>
+
 namespace utf8
 {
     class string;
+    class string_view;
 
     namespace detail
     {
+        // A bidirectional iterator over the characters of a valid byte stream.
+        // Characters are decoded on dereference, so the iterator returns them by value.
         class iterator
         {
         public:
+            typedef std::bidirectional_iterator_tag iterator_category;
+            typedef value_t value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef value_t const * pointer;
+            typedef value_t reference;
+
             iterator();
             ~iterator();
 
@@ -44,24 +57,35 @@ namespace utf8
 
             iterator operator ++ (int);
             iterator & operator ++ ();
+            iterator operator -- (int);
+            iterator & operator -- ();
 
+            // jumps are clamped to the end of the string
             iterator operator + (unsigned offset) const;
             iterator & operator += (unsigned offset);
 
-            value_t const & operator * () const;
+            value_t operator * () const;
+
+            // byte offset of the current character (the end has the size of the string)
+            std::size_t offset() const;
+            // index of the current character (the end has the length of the string)
+            std::size_t position() const;
 
         private:
-            iterator(byte_t const * strm, unsigned length);
+            iterator(string const * owner, byte_t const * begin, byte_t const * end, byte_t const * strm, std::size_t position);
 
-            // same data as used by internal next and next_s
+            // the byte stream and the first byte of the current character
+            byte_t const * begin_;
+            byte_t const * end_;
             byte_t const * strm_;
-            unsigned length_;
 
-            // the current value
-            value_t value_;
+            // the string and the character index, used to jump via the offset index of the string
+            string const * owner_;
+            std::size_t position_;
 
-            // string class needs access to the constructor
+            // string classes need access to the constructor
             friend class ::utf8::string;
+            friend class ::utf8::string_view;
         };
     }
 }
@@ -0,0 +1,190 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "line_reader.hxx"
+#include "decoding.hxx"
+#include "validation.hxx"
+
+#include <algorithm>
+#include <istream>
+#include <stdexcept>
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace utf8
+{
+    std::size_t const line_reader::DEFAULT_BLOCKSIZE;
+
+    line_reader::line_reader(int fd, char delim /* = '\n' */, std::size_t blocksize /* = DEFAULT_BLOCKSIZE */)
+        : fd_(fd)
+        , is_(nullptr)
+        , delim_(static_cast<byte_t>(delim))
+        , blocksize_(std::max<std::size_t>(blocksize, 16))
+        , buffer_(2 * blocksize_)
+        , begin_(0)
+        , end_(0)
+        , scanned_(0)
+        , valid_(0)
+        , failed_(false)
+        , eof_(false)
+        , lines_(0)
+    {
+    }
+
+    line_reader::line_reader(std::istream & is, char delim /* = '\n' */, std::size_t blocksize /* = DEFAULT_BLOCKSIZE */)
+        : fd_(-1)
+        , is_(&is)
+        , delim_(static_cast<byte_t>(delim))
+        , blocksize_(std::max<std::size_t>(blocksize, 16))
+        , buffer_(2 * blocksize_)
+        , begin_(0)
+        , end_(0)
+        , scanned_(0)
+        , valid_(0)
+        , failed_(false)
+        , eof_(false)
+        , lines_(0)
+    {
+    }
+
+    bool line_reader::next(string_view & line)
+    {
+        for (;;)
+        {
+            byte_t * const data = buffer_.data();
+            byte_t const * const found = scanned_ < end_
+                ? static_cast<byte_t const *>(std::memchr(data + scanned_, delim_, end_ - scanned_))
+                : nullptr;
+
+            std::size_t stop;
+            if (found)
+                stop = found - data;
+            else if (!fill())
+            {
+                if (begin_ == end_)
+                    return false;
+                stop = end_;
+            }
+            else
+                continue;
+
+            // the delimiter is ASCII, so the line ends at a character boundary
+            if (stop > valid_)
+                throw std::invalid_argument("Line contains non UTF-8 bytes.");
+
+            // fill() might have moved the bytes
+            byte_t const * const first = buffer_.data() + begin_;
+            line = string_view(first, stop - begin_, utf32_length(first, stop - begin_));
+            begin_ = scanned_ = std::min(stop + 1, end_);
+            ++lines_;
+            return true;
+        }
+    }
+
+    bool line_reader::next(string & line)
+    {
+        string_view view;
+        if (!next(view))
+            return false;
+        line = string(view, line.resource());
+        return true;
+    }
+
+    std::uint64_t line_reader::line_number() const
+    {
+        return lines_;
+    }
+
+    bool line_reader::fill()
+    {
+        scanned_ = end_;
+        if (eof_)
+            return false;
+
+        // keep the unread bytes, the buffer only grows for lines longer than a block
+        if (begin_)
+        {
+            std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+            end_ -= begin_;
+            scanned_ -= begin_;
+            valid_ -= begin_;
+            begin_ = 0;
+        }
+        if (buffer_.size() - end_ < blocksize_)
+            buffer_.resize(std::max(2 * buffer_.size(), end_ + blocksize_));
+
+        std::size_t const count = read(buffer_.data() + end_, buffer_.size() - end_);
+        end_ += count;
+        eof_ = !count;
+        validate();
+        return count != 0;
+    }
+
+    void line_reader::validate()
+    {
+        if (failed_ || valid_ == end_)
+            return;
+
+        byte_t const * const strm = buffer_.data() + valid_;
+        std::size_t const size = end_ - valid_;
+        detail::validation_result const result = detail::validate(strm, size, detail::nul_bytes::reject);
+        valid_ += result.offset;
+        if (result.valid)
+            return;
+
+        // a sequence cut by the end of the block is completed by the next one
+        std::size_t const rest = size - result.offset;
+        byte_t lower, upper;
+        if (eof_ || detail::lead_byte(strm[result.offset], lower, upper) <= rest || detail::maximal_subpart(strm + result.offset, rest) != rest)
+            failed_ = true;
+    }
+
+    std::size_t line_reader::read(byte_t * buffer, std::size_t size)
+    {
+        if (is_)
+        {
+            if (!*is_)
+                return 0;
+            is_->read(reinterpret_cast<char *>(buffer), static_cast<std::streamsize>(size));
+            if (is_->bad())
+                throw std::runtime_error("Could not read from the stream.");
+            return static_cast<std::size_t>(is_->gcount());
+        }
+
+        for (;;)
+        {
+#ifdef _WIN32
+            int const count = _read(fd_, buffer, static_cast<unsigned>(std::min<std::size_t>(size, 1u << 30)));
+#else
+            ssize_t const count = ::read(fd_, buffer, size);
+#endif
+            if (count >= 0)
+                return static_cast<std::size_t>(count);
+            if (errno != EINTR)
+                throw std::runtime_error("Could not read from the file descriptor.");
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef UTF8PP_CORE_LINEREADER_HXX
+#define UTF8PP_CORE_LINEREADER_HXX
+
+#include "types.hxx"
+#include "string.hxx"
+#include "string_view.hxx"
+
+#include <iosfwd>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace utf8
+{
+    // Reads lines from a file descriptor or an std::istream in large blocks.
+    // Every block is validated once (sequences split between blocks are carried over)
+    // and the lines are handed out as views into the reader's buffer, which are
+    // invalidated by the next call. Like std::getline the delimiter is not part of
+    // the line and a last line without a delimiter is returned as well.
+    // Lines longer than a block grow the buffer.
+    // NOTE: neither the descriptor nor the stream are closed by the reader
+    class line_reader
+    {
+    public:
+        static std::size_t const DEFAULT_BLOCKSIZE = 1 << 16;
+
+        explicit line_reader(int fd, char delim = '\n', std::size_t blocksize = DEFAULT_BLOCKSIZE);
+        explicit line_reader(std::istream & is, char delim = '\n', std::size_t blocksize = DEFAULT_BLOCKSIZE);
+
+        line_reader(line_reader const &) = delete;
+        line_reader & operator = (line_reader const &) = delete;
+
+        // Reads the next line, returns false at the end of the input.
+        // This will throw an std::invalid_argument exception if the line is not valid UTF-8
+        // or contains a NULL byte (the following lines can't be read then) and an
+        // std::runtime_error exception if reading fails.
+        bool next(string_view & line);
+        // same as above, but copies the line into a string (keeping its resource)
+        bool next(string & line);
+
+        // number of lines read so far
+        std::uint64_t line_number() const;
+
+    private:
+        // reads the next block, returns false at the end of the input
+        bool fill();
+        // validates the bytes read since the last call
+        void validate();
+        std::size_t read(byte_t * buffer, std::size_t size);
+
+        int fd_;
+        std::istream * is_;
+        byte_t delim_;
+        std::size_t blocksize_;
+
+        std::vector<byte_t> buffer_;
+        // the unread bytes are [begin_, end_), the delimiter search continues at scanned_
+        std::size_t begin_;
+        std::size_t end_;
+        std::size_t scanned_;
+        // bytes up to valid_ are valid UTF-8 (an invalid sequence starts there if failed_)
+        std::size_t valid_;
+        bool failed_;
+        bool eof_;
+        std::uint64_t lines_;
+    };
+}
+
+#endif // UTF8PP_CORE_LINEREADER_HXX
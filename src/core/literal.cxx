@@ -0,0 +1,55 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "literal.hxx"
+
+#include <iostream>
+
+namespace utf8
+{
+    byte_t const * literal::bytes() const
+    {
+        return reinterpret_cast<byte_t const *>(str_);
+    }
+
+    string_view literal::view() const
+    {
+        return string_view(bytes(), size_, length_);
+    }
+
+    literal::operator string_view () const
+    {
+        return view();
+    }
+
+    literal::const_iterator literal::begin() const
+    {
+        return view().begin();
+    }
+
+    literal::const_iterator literal::end() const
+    {
+        return view().end();
+    }
+}
+
+std::ostream & operator << (std::ostream & os, utf8::literal const & lit)
+{
+    return os.write(lit.c_str(), lit.size());
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef UTF8PP_CORE_LITERAL_HXX
+#define UTF8PP_CORE_LITERAL_HXX
+
+#include "types.hxx"
+#include "iterator.hxx"
+#include "string_view.hxx"
+
+#include <iosfwd>
+#include <stdexcept>
+#include <cstddef>
+
+namespace utf8
+{
+    namespace detail
+    {
+        // Compile time validation of string literals (C++11 constexpr, so every function is a
+        // single return statement). The rules are the ones of detail::validate() plus no NULL bytes.
+        // The bytes are split in halves at character boundaries, so the recursion depth stays
+        // logarithmic in the size of the literal.
+
+        static std::size_t const LITERAL_INVALID = static_cast<std::size_t>(-1);
+
+        constexpr unsigned literal_byte(char const * str, std::size_t i)
+        {
+            return static_cast<unsigned char>(str[i]);
+        }
+
+        constexpr bool literal_continuation(char const * str, std::size_t end, std::size_t i, unsigned low = 0x80, unsigned high = 0xBF)
+        {
+            return i < end && literal_byte(str, i) >= low && literal_byte(str, i) <= high;
+        }
+
+        // the length of the sequence at i in bytes, 0 if it is invalid
+        constexpr std::size_t literal_sequence(char const * str, std::size_t end, std::size_t i, unsigned lead)
+        {
+            return
+                lead == 0 ? 0 :
+                lead < 0x80 ? 1 :
+                lead < 0xC2 ? 0 :
+                lead < 0xE0 ? (literal_continuation(str, end, i + 1) ? 2 : 0) :
+                lead < 0xF0 ? ((
+                    literal_continuation(str, end, i + 1, lead == 0xE0 ? 0xA0 : 0x80, lead == 0xED ? 0x9F : 0xBF) &&
+                    literal_continuation(str, end, i + 2)) ? 3 : 0) :
+                lead < 0xF5 ? ((
+                    literal_continuation(str, end, i + 1, lead == 0xF0 ? 0x90 : 0x80, lead == 0xF4 ? 0x8F : 0xBF) &&
+                    literal_continuation(str, end, i + 2) &&
+                    literal_continuation(str, end, i + 3)) ? 4 : 0) :
+                0;
+        }
+
+        constexpr std::size_t literal_scan(char const * str, std::size_t i, std::size_t end, std::size_t length);
+
+        constexpr std::size_t literal_step(char const * str, std::size_t i, std::size_t end, std::size_t length, std::size_t sequence)
+        {
+            return sequence ? literal_scan(str, i + sequence, end, length + 1) : LITERAL_INVALID;
+        }
+
+        // walks the characters of [i, end) one by one
+        constexpr std::size_t literal_scan(char const * str, std::size_t i, std::size_t end, std::size_t length)
+        {
+            return i == end ? length : literal_step(str, i, end, length, literal_sequence(str, end, i, literal_byte(str, i)));
+        }
+
+        // the first byte at or after i that does not continue a character (at most 3 steps)
+        constexpr std::size_t literal_boundary(char const * str, std::size_t i, std::size_t end, unsigned steps = 0)
+        {
+            return (i < end && steps < 3 && (literal_byte(str, i) & 0xC0) == 0x80) ? literal_boundary(str, i + 1, end, steps + 1) : i;
+        }
+
+        constexpr std::size_t literal_sum(std::size_t lhs, std::size_t rhs)
+        {
+            return (lhs == LITERAL_INVALID || rhs == LITERAL_INVALID) ? LITERAL_INVALID : lhs + rhs;
+        }
+
+        constexpr std::size_t literal_count(char const * str, std::size_t begin, std::size_t end);
+
+        constexpr std::size_t literal_split(char const * str, std::size_t begin, std::size_t middle, std::size_t end)
+        {
+            return literal_sum(literal_count(str, begin, middle), literal_count(str, middle, end));
+        }
+
+        // number of characters in [begin, end) or LITERAL_INVALID
+        constexpr std::size_t literal_count(char const * str, std::size_t begin, std::size_t end)
+        {
+            return end - begin <= 64
+                ? literal_scan(str, begin, end, 0)
+                : literal_split(str, begin, literal_boundary(str, begin + (end - begin) / 2, end), end);
+        }
+
+        // passes the length through, throws (fails to compile in constant expressions) if it is invalid
+        constexpr std::size_t literal_checked(std::size_t length)
+        {
+            return length != LITERAL_INVALID
+                ? length
+                : throw std::invalid_argument("String literal contains non UTF-8 bytes.");
+        }
+
+        // number of characters of a string literal (counted once)
+        constexpr std::size_t literal_length(char const * str, std::size_t size)
+        {
+            return literal_checked(literal_count(str, 0, size));
+        }
+    }
+
+    class literal;
+
+    inline namespace literals
+    {
+        // validates the literal and counts its characters
+        constexpr literal operator "" _u8 (char const * str, std::size_t size);
+    }
+
+    // A validated, non allocating reference to a string literal created by the _u8 literal.
+    // The length is computed by the compiler, invalid literals don't compile if the result
+    // is constexpr (otherwise the check may run at runtime and throw std::invalid_argument):
+    //
+    //     using namespace utf8::literals;
+    //     constexpr utf8::literal shades = u8"(-■_■)"_u8;
+    //     static_assert(shades.length() == 6, "");
+    //
+    // Literals convert to validated views, so they can be passed wherever a utf8::string_view
+    // is read, and copied into a utf8::string without scanning them again.
+    class literal
+    {
+    public:
+        constexpr literal()
+            : str_("")
+            , size_(0)
+            , length_(0)
+        {
+        }
+
+        // the characters and bytes without the terminating NULL byte
+        constexpr std::size_t length() const
+        {
+            return length_;
+        }
+
+        constexpr std::size_t size() const
+        {
+            return size_;
+        }
+
+        constexpr bool empty() const
+        {
+            return !size_;
+        }
+
+        // NULL terminated
+        constexpr char const * c_str() const
+        {
+            return str_;
+        }
+
+        byte_t const * bytes() const;
+        string_view view() const;
+        operator string_view () const;
+
+        typedef detail::iterator const_iterator;
+        const_iterator begin() const;
+        const_iterator end() const;
+
+    private:
+        constexpr literal(char const * str, std::size_t size, std::size_t length)
+            : str_(str)
+            , size_(size)
+            , length_(length)
+        {
+        }
+
+        char const * str_;
+        std::size_t size_;
+        std::size_t length_;
+
+        friend constexpr literal literals::operator "" _u8 (char const * str, std::size_t size);
+    };
+
+    inline namespace literals
+    {
+        constexpr literal operator "" _u8 (char const * str, std::size_t size)
+        {
+            return literal(str, size, detail::literal_length(str, size));
+        }
+    }
+}
+
+std::ostream & operator << (std::ostream & os, utf8::literal const & lit);
+
+#endif // UTF8PP_CORE_LITERAL_HXX
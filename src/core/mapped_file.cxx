@@ -0,0 +1,235 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mapped_file.hxx"
+#include "validation.hxx"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    using utf8::byte_t;
+
+    void cannot_map(std::string const & path)
+    {
+        throw std::runtime_error("Could not map file " + path + ".");
+    }
+
+#ifdef _WIN32
+    byte_t const * map_file(std::string const & path, std::size_t & size)
+    {
+        HANDLE const file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            cannot_map(path);
+
+        LARGE_INTEGER filesize;
+        if (!GetFileSizeEx(file, &filesize) || static_cast<unsigned long long>(filesize.QuadPart) > static_cast<std::size_t>(-1))
+        {
+            CloseHandle(file);
+            cannot_map(path);
+        }
+        size = static_cast<std::size_t>(filesize.QuadPart);
+        if (!size)
+        {
+            CloseHandle(file);
+            return nullptr;
+        }
+
+        // the view keeps the mapping alive
+        HANDLE const mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping)
+            cannot_map(path);
+        void const * view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (!view)
+            cannot_map(path);
+        return static_cast<byte_t const *>(view);
+    }
+
+    void unmap_file(byte_t const * strm, std::size_t)
+    {
+        UnmapViewOfFile(strm);
+    }
+#else
+    byte_t const * map_file(std::string const & path, std::size_t & size)
+    {
+        int const file = open(path.c_str(), O_RDONLY);
+        if (file < 0)
+            cannot_map(path);
+
+        struct stat info;
+        if (fstat(file, &info) || static_cast<unsigned long long>(info.st_size) > static_cast<std::size_t>(-1))
+        {
+            close(file);
+            cannot_map(path);
+        }
+        size = static_cast<std::size_t>(info.st_size);
+        if (!size)
+        {
+            close(file);
+            return nullptr;
+        }
+
+        // the mapping stays valid after closing the file
+        void * const view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        close(file);
+        if (view == MAP_FAILED)
+            cannot_map(path);
+
+        // the validator reads the file front to back
+        madvise(view, size, MADV_SEQUENTIAL);
+        return static_cast<byte_t const *>(view);
+    }
+
+    void unmap_file(byte_t const * strm, std::size_t size)
+    {
+        munmap(const_cast<byte_t *>(strm), size);
+    }
+#endif
+}
+
+namespace utf8
+{
+    mapped_file::mapped_file()
+        : strm_(nullptr)
+        , size_(0)
+        , length_(0)
+    {
+    }
+
+    mapped_file::mapped_file(char const * path)
+        : strm_(nullptr)
+        , size_(0)
+        , length_(0)
+    {
+        std::string const filename(path ? path : "");
+        strm_ = map_file(filename, size_);
+
+        detail::validation_result const result = detail::validate(strm_, size_, detail::nul_bytes::reject);
+        if (!result.valid)
+        {
+            unmap();
+            throw std::invalid_argument("File " + filename + " contains non UTF-8 bytes at offset " + std::to_string(result.offset) + ".");
+        }
+        length_ = result.length;
+    }
+
+    mapped_file::mapped_file(std::string const & path)
+        : mapped_file(path.c_str())
+    {
+    }
+
+    mapped_file::~mapped_file()
+    {
+        unmap();
+    }
+
+    mapped_file::mapped_file(mapped_file && src)
+        : strm_(src.strm_)
+        , size_(src.size_)
+        , length_(src.length_)
+    {
+        src.strm_ = nullptr;
+        src.size_ = 0;
+        src.length_ = 0;
+    }
+
+    mapped_file & mapped_file::operator = (mapped_file && src)
+    {
+        if (this != &src)
+        {
+            unmap();
+            std::swap(strm_, src.strm_);
+            std::swap(size_, src.size_);
+            std::swap(length_, src.length_);
+        }
+        return *this;
+    }
+
+    void mapped_file::unmap()
+    {
+        if (strm_)
+            unmap_file(strm_, size_);
+        strm_ = nullptr;
+        size_ = 0;
+        length_ = 0;
+    }
+
+    string_view mapped_file::view() const
+    {
+        return string_view(strm_, size_, length_);
+    }
+
+    std::size_t mapped_file::length() const
+    {
+        return length_;
+    }
+
+    byte_t const * mapped_file::bytes() const
+    {
+        return strm_;
+    }
+
+    std::size_t mapped_file::size() const
+    {
+        return size_;
+    }
+
+    bool mapped_file::empty() const
+    {
+        return !size_;
+    }
+
+    mapped_file::const_iterator mapped_file::begin() const
+    {
+        return view().begin();
+    }
+
+    mapped_file::const_iterator mapped_file::end() const
+    {
+        return view().end();
+    }
+
+    mapped_file::const_reverse_iterator mapped_file::rbegin() const
+    {
+        return const_reverse_iterator(end());
+    }
+
+    mapped_file::const_reverse_iterator mapped_file::rend() const
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    value_t mapped_file::operator [] (unsigned index) const
+    {
+        return view()[index];
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef UTF8PP_CORE_MAPPEDFILE_HXX
+#define UTF8PP_CORE_MAPPEDFILE_HXX
+
+#include "types.hxx"
+#include "iterator.hxx"
+#include "string_view.hxx"
+
+#include <iterator>
+#include <string>
+#include <cstddef>
+
+namespace utf8
+{
+    // A file mapped read-only into memory and validated as UTF-8.
+    // Loading costs page faults instead of copies, the pages are read sequentially
+    // by the validator (which uses multiple threads above the parallel_validation() threshold).
+    // NOTE: just like utf8::string the file must not contain a NULL byte
+    class mapped_file
+    {
+    public:
+        mapped_file();
+        // This constructor will throw an std::runtime_error exception if the file can't be mapped
+        // and an std::invalid_argument exception if it is not valid UTF-8.
+        explicit mapped_file(char const * path);
+        explicit mapped_file(std::string const & path);
+        ~mapped_file();
+
+        mapped_file(mapped_file && src);
+        mapped_file & operator = (mapped_file && src);
+
+        // the file content (valid as long as the file is mapped)
+        string_view view() const;
+
+        // get the length of the file in characters
+        std::size_t length() const;
+        // access the bytes directly (there are size() of them)
+        byte_t const * bytes() const;
+        // number of bytes
+        std::size_t size() const;
+        bool empty() const;
+
+        // iterators
+        typedef detail::iterator const_iterator;
+        typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+        const_iterator begin() const;
+        const_iterator end() const;
+        const_reverse_iterator rbegin() const;
+        const_reverse_iterator rend() const;
+
+        // index operator (walks from the first character)
+        value_t operator [] (unsigned index) const;
+
+    private:
+        mapped_file(mapped_file const &);
+        mapped_file & operator = (mapped_file const &);
+
+        void unmap();
+
+        byte_t const * strm_;
+        std::size_t size_;
+        std::size_t length_;
+    };
+}
+
+#endif // UTF8PP_CORE_MAPPEDFILE_HXX
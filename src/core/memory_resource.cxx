@@ -0,0 +1,175 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "memory_resource.hxx"
+
+#include <algorithm>
+#include <new>
+
+#include <cstdint>
+
+namespace
+{
+#ifndef UTF8PP_PMR
+    // operator new and delete, aligned to max_align_t at most
+    class new_delete_resource : public utf8::memory_resource
+    {
+    private:
+        void * do_allocate(std::size_t bytes, std::size_t) override
+        {
+            return ::operator new(bytes);
+        }
+
+        void do_deallocate(void * p, std::size_t, std::size_t) override
+        {
+            ::operator delete(p);
+        }
+
+        bool do_is_equal(utf8::memory_resource const & other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+#endif
+}
+
+namespace utf8
+{
+#ifndef UTF8PP_PMR
+    memory_resource::~memory_resource() = default;
+
+    void * memory_resource::allocate(std::size_t bytes, std::size_t alignment /* = alignof(std::max_align_t) */)
+    {
+        return do_allocate(bytes, alignment);
+    }
+
+    void memory_resource::deallocate(void * p, std::size_t bytes, std::size_t alignment /* = alignof(std::max_align_t) */)
+    {
+        do_deallocate(p, bytes, alignment);
+    }
+
+    bool memory_resource::is_equal(memory_resource const & other) const noexcept
+    {
+        return do_is_equal(other);
+    }
+
+    memory_resource * default_resource()
+    {
+        static ::new_delete_resource resource;
+        return &resource;
+    }
+#endif
+
+    memory_resource * resource_or_default(memory_resource * resource)
+    {
+#ifdef UTF8PP_PMR
+        return resource ? resource : std::pmr::get_default_resource();
+#else
+        return resource ? resource : default_resource();
+#endif
+    }
+
+    // the blocks form a list, the header is followed by the memory handed out
+    struct arena_resource::block
+    {
+        block * next;
+        std::size_t size;
+    };
+
+    arena_resource::arena_resource(std::size_t blocksize /* = 4096 */, memory_resource * upstream /* = nullptr */)
+        : upstream_(resource_or_default(upstream))
+        , buffer_(nullptr)
+        , buffersize_(0)
+        , blocksize_(std::max<std::size_t>(blocksize, 2 * sizeof(block)))
+        , blocks_(nullptr)
+        , count_(0)
+        , current_(nullptr)
+        , available_(0)
+    {
+    }
+
+    arena_resource::arena_resource(void * buffer, std::size_t size, memory_resource * upstream /* = nullptr */)
+        : upstream_(resource_or_default(upstream))
+        , buffer_(static_cast<unsigned char *>(buffer))
+        , buffersize_(size)
+        , blocksize_(std::max<std::size_t>(size, 4096))
+        , blocks_(nullptr)
+        , count_(0)
+        , current_(buffer_)
+        , available_(size)
+    {
+    }
+
+    arena_resource::~arena_resource()
+    {
+        release();
+    }
+
+    void arena_resource::release()
+    {
+        while (blocks_)
+        {
+            block * const next = blocks_->next;
+            upstream_->deallocate(blocks_, blocks_->size, alignof(std::max_align_t));
+            blocks_ = next;
+        }
+        current_ = buffer_;
+        available_ = buffersize_;
+    }
+
+    std::size_t arena_resource::blocks() const
+    {
+        return count_;
+    }
+
+    void * arena_resource::do_allocate(std::size_t bytes, std::size_t alignment)
+    {
+        std::size_t padding = (alignment - reinterpret_cast<std::uintptr_t>(current_) % alignment) % alignment;
+        if (!current_ || padding + bytes > available_)
+        {
+            // a new block, at least as big as the request
+            std::size_t const header = (sizeof(block) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+            std::size_t const size = std::max(blocksize_, header + bytes + alignment);
+            block * const fresh = static_cast<block *>(upstream_->allocate(size, alignof(std::max_align_t)));
+            fresh->next = blocks_;
+            fresh->size = size;
+            blocks_ = fresh;
+            ++count_;
+
+            current_ = reinterpret_cast<unsigned char *>(fresh) + header;
+            available_ = size - header;
+            padding = (alignment - reinterpret_cast<std::uintptr_t>(current_) % alignment) % alignment;
+        }
+
+        void * const result = current_ + padding;
+        current_ += padding + bytes;
+        available_ -= padding + bytes;
+        return result;
+    }
+
+    void arena_resource::do_deallocate(void *, std::size_t, std::size_t)
+    {
+        // memory is only given back all at once
+    }
+
+    bool arena_resource::do_is_equal(memory_resource const & other) const noexcept
+    {
+        return this == &other;
+    }
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef UTF8PP_CORE_MEMORYRESOURCE_HXX
+#define UTF8PP_CORE_MEMORYRESOURCE_HXX
+
+#include <cstddef>
+
+// std::pmr is used where the standard library has it (C++17),
+// otherwise the library brings the parts utf8::string needs
+#if defined(__has_include) && ((__cplusplus >= 201703L) || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L))
+#if __has_include(<memory_resource>)
+#define UTF8PP_PMR
+#endif
+#endif
+
+#ifdef UTF8PP_PMR
+#include <memory_resource>
+#endif
+
+namespace utf8
+{
+#ifdef UTF8PP_PMR
+    typedef std::pmr::memory_resource memory_resource;
+    template <typename T>
+    using polymorphic_allocator = std::pmr::polymorphic_allocator<T>;
+#else
+    // the interface of std::pmr::memory_resource
+    class memory_resource
+    {
+    public:
+        virtual ~memory_resource();
+
+        void * allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+        void deallocate(void * p, std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+        bool is_equal(memory_resource const & other) const noexcept;
+
+    private:
+        virtual void * do_allocate(std::size_t bytes, std::size_t alignment) = 0;
+        virtual void do_deallocate(void * p, std::size_t bytes, std::size_t alignment) = 0;
+        virtual bool do_is_equal(memory_resource const & other) const noexcept = 0;
+    };
+
+    // the resource used if none is given (operator new and delete)
+    memory_resource * default_resource();
+
+    // an allocator using a memory resource, just like std::pmr::polymorphic_allocator
+    template <typename T>
+    class polymorphic_allocator
+    {
+    public:
+        typedef T value_type;
+
+        polymorphic_allocator() noexcept
+            : resource_(default_resource())
+        {
+        }
+
+        polymorphic_allocator(memory_resource * resource) noexcept
+            : resource_(resource)
+        {
+        }
+
+        template <typename U>
+        polymorphic_allocator(polymorphic_allocator<U> const & other) noexcept
+            : resource_(other.resource())
+        {
+        }
+
+        T * allocate(std::size_t n)
+        {
+            return static_cast<T *>(resource_->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T * p, std::size_t n)
+        {
+            resource_->deallocate(p, n * sizeof(T), alignof(T));
+        }
+
+        // copies of containers use the default resource
+        polymorphic_allocator select_on_container_copy_construction() const
+        {
+            return polymorphic_allocator();
+        }
+
+        memory_resource * resource() const
+        {
+            return resource_;
+        }
+
+    private:
+        memory_resource * resource_;
+    };
+
+    template <typename T, typename U>
+    bool operator == (polymorphic_allocator<T> const & lhs, polymorphic_allocator<U> const & rhs) noexcept
+    {
+        return lhs.resource() == rhs.resource() || lhs.resource()->is_equal(*rhs.resource());
+    }
+
+    template <typename T, typename U>
+    bool operator != (polymorphic_allocator<T> const & lhs, polymorphic_allocator<U> const & rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+#endif
+
+    // A monotonic arena: allocations are carved out of an optional initial buffer and then
+    // out of blocks taken from the upstream resource, which are only given back by release()
+    // or the destructor. Meant for many short-lived strings, for example one arena per
+    // request and thread.
+    // NOTE: not thread safe
+    class arena_resource : public memory_resource
+    {
+    public:
+        // the upstream resource defaults to default_resource()
+        explicit arena_resource(std::size_t blocksize = 4096, memory_resource * upstream = nullptr);
+        // the buffer is used first and is not owned by the arena
+        arena_resource(void * buffer, std::size_t size, memory_resource * upstream = nullptr);
+        ~arena_resource();
+
+        // frees all blocks and starts over with the initial buffer,
+        // everything allocated from the arena becomes invalid
+        void release();
+
+        // number of blocks taken from the upstream resource since construction
+        std::size_t blocks() const;
+
+    private:
+        arena_resource(arena_resource const &);
+        arena_resource & operator = (arena_resource const &);
+
+        void * do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void * p, std::size_t bytes, std::size_t alignment) override;
+        bool do_is_equal(memory_resource const & other) const noexcept override;
+
+        struct block;
+
+        memory_resource * upstream_;
+        unsigned char * buffer_;
+        std::size_t buffersize_;
+        std::size_t blocksize_;
+        block * blocks_;
+        std::size_t count_;
+        // the free part of the current block
+        unsigned char * current_;
+        std::size_t available_;
+    };
+
+    // the resource used if nullptr is given
+    memory_resource * resource_or_default(memory_resource * resource);
+}
+
+#endif // UTF8PP_CORE_MEMORYRESOURCE_HXX
@@ -0,0 +1,336 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "normalization.hxx"
+#include "normalization_tables.hxx"
+#include "encoding.hxx"
+#include "detail.hxx"
+
+#include <algorithm>
+#include <vector>
+
+#include <cstdint>
+
+namespace
+{
+    using namespace utf8;
+    using namespace utf8::normalization_tables;
+    using utf8::detail::count_trailing_zeros;
+    using utf8::detail::decode_valid;
+
+    // Hangul syllables are composed of a leading consonant, a vowel and an optional trailing consonant
+    value_t const S_BASE = 0xAC00, L_BASE = 0x1100, V_BASE = 0x1161, T_BASE = 0x11A7;
+    value_t const L_COUNT = 19, V_COUNT = 21, T_COUNT = 28, N_COUNT = V_COUNT * T_COUNT, S_COUNT = L_COUNT * N_COUNT;
+
+    // characters normalized at once, larger texts are normalized in chunks split at stable starters
+    std::size_t const CHUNK = 256;
+
+    struct form_traits
+    {
+        explicit form_traits(normalization_form form)
+            : shift(form == normalization_form::nfc ? NFC_SHIFT
+                  : form == normalization_form::nfkc ? NFKC_SHIFT
+                  : form == normalization_form::nfd ? NFD_SHIFT : NFKD_SHIFT)
+            , compose(form == normalization_form::nfc || form == normalization_form::nfkc)
+            , compatibility(form == normalization_form::nfkc || form == normalization_form::nfkd)
+            , minimum(quick_check_minimum[shift / 2])
+            , unchanged(quick_check_minimum[compatibility ? NFKD_SHIFT / 2 : NFD_SHIFT / 2])
+            // lead bytes of two byte characters hold the bits 6 - 10
+            , limit(static_cast<byte_t>(minimum < 0x800 ? (0xC0 | (minimum >> 6)) - 1 : 0xDF))
+        {
+        }
+
+        unsigned quick_check(property const & p) const
+        {
+            return (p.flags >> shift) & 3;
+        }
+
+        unsigned shift;
+        bool compose;
+        bool compatibility;
+        // characters below are starters passing the quick check
+        value_t minimum;
+        // characters below don't even decompose (the composed forms decompose YES characters as well)
+        value_t unchanged;
+        // Bytes up to the limit only encode characters below the minimum (UTF-8 keeps the
+        // order of the code points). It is above every continuation byte.
+        byte_t limit;
+    };
+
+    // the position of the first byte above the limit at or after pos
+    std::size_t skip_below(byte_t const * strm, std::size_t pos, std::size_t size, byte_t limit)
+    {
+#ifdef UTF8PP_SSE2
+        __m128i const limits = _mm_set1_epi8(static_cast<char>(limit));
+        for (; pos + 16 <= size; pos += 16)
+        {
+            __m128i const block = _mm_loadu_si128(reinterpret_cast<__m128i const *>(strm + pos));
+            if (unsigned const mask = 0xFFFF & ~static_cast<unsigned>(_mm_movemask_epi8(
+                    _mm_cmpeq_epi8(_mm_max_epu8(block, limits), limits))))
+                return pos + count_trailing_zeros(mask);
+        }
+#endif
+        while (pos < size && strm[pos] <= limit)
+            ++pos;
+        return pos;
+    }
+
+    // The quick check: checks the text up to the first character which is not YES for the form (or violates the
+    // canonical order) and returns its quick check value. stable is set to the start of the last
+    // starter before it which is YES: nothing in front of that position is changed by normalization.
+    unsigned scan(byte_t const * strm, std::size_t size, form_traits const & form, std::size_t & stable)
+    {
+        unsigned last = 0;
+        stable = 0;
+        std::size_t pos = 0;
+        while (pos < size)
+        {
+            if (strm[pos] <= form.limit)
+            {
+                // runs of characters below the minimum (ASCII at least) are stable starters
+                pos = skip_below(strm, pos + 1, size, form.limit);
+                stable = pos - 1;
+                while ((strm[stable] & 0xC0) == 0x80)
+                    --stable;
+                last = 0;
+                continue;
+            }
+
+            std::size_t const start = pos;
+            value_t const c = decode_valid(strm, pos);
+            if (c < form.minimum)
+            {
+                stable = start;
+                last = 0;
+                continue;
+            }
+
+            property const & p = lookup(c);
+            if (p.ccc && last > p.ccc)
+                return NO;
+            if (unsigned const result = form.quick_check(p))
+                return result;
+            if (!p.ccc)
+                stable = start;
+            last = p.ccc;
+        }
+        return YES;
+    }
+
+    class normalizer
+    {
+    public:
+        explicit normalizer(form_traits const & form)
+            : form_(form)
+        {
+            chars_.reserve(CHUNK + 32);
+            classes_.reserve(CHUNK + 32);
+        }
+
+        // Normalizes valid UTF-8 starting at a stable position and passes the result in chunks
+        // to the sink (called with the characters and their number). Stops as soon as the sink
+        // returns false and returns false then.
+        template <typename Sink>
+        bool run(byte_t const * strm, std::size_t size, Sink sink)
+        {
+            std::size_t pos = 0;
+            while (pos < size)
+            {
+                value_t const c = decode_valid(strm, pos);
+                if (c < form_.unchanged && chars_.size() < CHUNK)
+                {
+                    push(c, 0);
+                    continue;
+                }
+                property const & p = lookup(c);
+                // nothing combines across a stable starter
+                if (chars_.size() >= CHUNK && !p.ccc && form_.quick_check(p) == YES && !flush(sink))
+                    return false;
+                decompose(c, p);
+            }
+            return flush(sink);
+        }
+
+    private:
+        // appends a character, sorting it into the canonical order
+        void push(value_t c, std::uint8_t ccc)
+        {
+            std::size_t n = chars_.size();
+            chars_.push_back(c);
+            classes_.push_back(ccc);
+            while (ccc && n && classes_[n - 1] > ccc)
+            {
+                std::swap(chars_[n], chars_[n - 1]);
+                std::swap(classes_[n], classes_[n - 1]);
+                --n;
+            }
+        }
+
+        void decompose(value_t c, property const & p)
+        {
+            if (c - S_BASE < S_COUNT)
+            {
+                value_t const index = c - S_BASE;
+                push(L_BASE + index / N_COUNT, 0);
+                push(V_BASE + index % N_COUNT / T_COUNT, 0);
+                if (index % T_COUNT)
+                    push(T_BASE + index % T_COUNT, 0);
+                return;
+            }
+
+            std::uint16_t const decomposition = form_.compatibility ? p.compatibility : p.canonical;
+            if (!decomposition)
+            {
+                push(c, p.ccc);
+                return;
+            }
+            char32_t const * d = decompositions + decomposition;
+            for (char32_t const * end = d + 1 + *d; ++d != end; )
+                push(*d, lookup(*d).ccc);
+        }
+
+        // the primary composite of the pair (0 if there is none)
+        static value_t composite(value_t first, value_t second)
+        {
+            if (first - L_BASE < L_COUNT && second - V_BASE < V_COUNT)
+                return S_BASE + ((first - L_BASE) * V_COUNT + second - V_BASE) * T_COUNT;
+            if (first - S_BASE < S_COUNT && !((first - S_BASE) % T_COUNT) && second - T_BASE - 1 < T_COUNT - 1)
+                return first + second - T_BASE;
+
+            std::uint64_t const key = (static_cast<std::uint64_t>(first) << 21) | second;
+            std::uint64_t const * end = composition_keys + composition_count;
+            std::uint64_t const * found = std::lower_bound(composition_keys, end, key);
+            return found != end && *found == key ? composition_values[found - composition_keys] : 0;
+        }
+
+        // the canonical composition algorithm
+        void compose()
+        {
+            if (chars_.empty())
+                return;
+
+            std::size_t starter = 0, out = 1;
+            // a leading non-starter blocks everything after it
+            unsigned last = classes_[0] ? 256 : 0;
+            for (std::size_t n = 1; n < chars_.size(); ++n)
+            {
+                value_t const c = chars_[n];
+                unsigned const ccc = classes_[n];
+                // combines with the last starter unless a character in between blocks it
+                value_t const combined = last < ccc || !last ? composite(chars_[starter], c) : 0;
+                if (combined)
+                {
+                    chars_[starter] = combined;
+                    continue;
+                }
+                if (!ccc)
+                    starter = out;
+                last = ccc;
+                chars_[out++] = c;
+            }
+            chars_.resize(out);
+        }
+
+        template <typename Sink>
+        bool flush(Sink & sink)
+        {
+            if (form_.compose)
+                compose();
+            bool const more = chars_.empty() || sink(chars_.data(), chars_.size());
+            chars_.clear();
+            classes_.clear();
+            return more;
+        }
+
+        form_traits form_;
+        std::vector<char32_t> chars_;
+        std::vector<std::uint8_t> classes_;
+    };
+}
+
+namespace utf8
+{
+    bool is_normalized(string_view const & text, normalization_form form /* = normalization_form::nfc */)
+    {
+        // validates the text
+        text.length();
+        form_traits const traits(form);
+        std::size_t stable;
+        unsigned const result = scan(text.bytes(), text.size(), traits, stable);
+        if (result != MAYBE)
+            return result == YES;
+
+        // compare the normalized rest with the original one
+        byte_t const * strm = text.bytes() + stable;
+        std::size_t const size = text.size() - stable;
+        std::size_t pos = 0;
+        normalizer normalizer(traits);
+        return normalizer.run(strm, size, [&](char32_t const * chars, std::size_t count) -> bool
+        {
+            byte_t encoded[4];
+            for (std::size_t n = 0; n < count; ++n)
+            {
+                unsigned const bytes = detail::encode(chars[n], encoded);
+                if (size - pos < bytes || !std::equal(encoded, encoded + bytes, strm + pos))
+                    return false;
+                pos += bytes;
+            }
+            return true;
+        }) && pos == size;
+    }
+
+    string normalize(string_view const & text, normalization_form form /* = normalization_form::nfc */,
+                     memory_resource * resource /* = nullptr */)
+    {
+        // validates the text
+        text.length();
+        form_traits const traits(form);
+        std::size_t stable;
+        string result(nullptr, resource);
+        if (scan(text.bytes(), text.size(), traits, stable) == YES)
+        {
+            result.append(text);
+            return result;
+        }
+
+        result.reserve(text.size() + text.size() / 8);
+        result.append(string_view(text.bytes(), stable));
+        normalizer normalizer(traits);
+        normalizer.run(text.bytes() + stable, text.size() - stable, [&](char32_t const * chars, std::size_t count) -> bool
+        {
+            result.append(chars, count);
+            return true;
+        });
+        return result;
+    }
+
+    string normalize(char const * text, normalization_form form /* = normalization_form::nfc */,
+                     memory_resource * resource /* = nullptr */)
+    {
+        return normalize(string_view(text), form, resource);
+    }
+
+    string normalize(string && text, normalization_form form /* = normalization_form::nfc */)
+    {
+        std::size_t stable;
+        if (scan(text.bytes(), text.size(), form_traits(form), stable) == YES)
+            return std::move(text);
+        return normalize(string_view(text), form, text.resource());
+    }
+}
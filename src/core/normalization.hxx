@@ -0,0 +1,57 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef UTF8PP_CORE_NORMALIZATION_HXX
+#define UTF8PP_CORE_NORMALIZATION_HXX
+
+#include "string.hxx"
+#include "string_view.hxx"
+#include "memory_resource.hxx"
+
+namespace utf8
+{
+    // the Unicode normalization forms (see UAX #15)
+    enum class normalization_form
+    {
+        nfc,
+        nfd,
+        nfkc,
+        nfkd
+    };
+
+    // Normalization starts with a quick check of the text, which skips ASCII blocks and stops
+    // at the first character that might change. Text that is normalized already is
+    // recognized by it alone and only the part after that character is ever rewritten.
+    // All functions throw an std::invalid_argument exception if the text is not valid UTF-8.
+
+    bool is_normalized(string_view const & text, normalization_form form = normalization_form::nfc);
+
+    // returns a normalized copy of the text
+    string normalize(string_view const & text, normalization_form form = normalization_form::nfc,
+                     memory_resource * resource = nullptr);
+    string normalize(char const * text, normalization_form form = normalization_form::nfc,
+                     memory_resource * resource = nullptr);
+    // returns the string itself if it is normalized already (without copying it)
+    string normalize(string && text, normalization_form form = normalization_form::nfc);
+}
+
+#endif // UTF8PP_CORE_NORMALIZATION_HXX
@@ -0,0 +1,89 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef UTF8PP_CORE_NORMALIZATIONTABLES_HXX
+#define UTF8PP_CORE_NORMALIZATIONTABLES_HXX
+
+#include "types.hxx"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace utf8
+{
+    // The Unicode data used by normalization.cxx, generated by tools/normalization_tables.py.
+    namespace normalization_tables
+    {
+        // quick check values (two bits per form in property::flags)
+        enum quick_check_value : unsigned
+        {
+            YES = 0,
+            MAYBE = 1,
+            NO = 2
+        };
+
+        // shifts of the quick check values in property::flags
+        unsigned const NFC_SHIFT = 0;
+        unsigned const NFKC_SHIFT = 2;
+        unsigned const NFD_SHIFT = 4;
+        unsigned const NFKD_SHIFT = 6;
+
+        struct property
+        {
+            // canonical combining class
+            std::uint8_t ccc;
+            // quick check values of all four forms
+            std::uint8_t flags;
+            // Full decompositions as indices into decompositions (0 if the character doesn't
+            // decompose). They point at the length, which is followed by the characters.
+            // Hangul syllables are decomposed algorithmically.
+            std::uint16_t canonical;
+            std::uint16_t compatibility;
+        };
+
+        // characters per block of stage2
+        std::size_t const BLOCK = 128;
+
+        // Two stage table: stage1 holds the block of every BLOCK characters,
+        // the block holds the property index of each character.
+        extern std::uint8_t const stage1[];
+        extern std::uint16_t const stage2[];
+        extern property const properties[];
+        extern char32_t const decompositions[];
+
+        // characters below these are starters which are YES in every context
+        // (indexed by the shift of the form divided by 2)
+        extern value_t const quick_check_minimum[];
+
+        // Primary composites sorted by their pair (first << 21 | second)
+        extern std::uint64_t const composition_keys[];
+        extern char32_t const composition_values[];
+        extern std::size_t const composition_count;
+
+        inline property const & lookup(value_t c)
+        {
+            return properties[stage2[stage1[c / BLOCK] * BLOCK + c % BLOCK]];
+        }
+    }
+}
+
+#endif // UTF8PP_CORE_NORMALIZATIONTABLES_HXX
@@ -0,0 +1,185 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "offset_index.hxx"
+
+#include <new>
+
+namespace
+{
+    // records the checkpoints in the bytes [offset, size)
+    template <typename Table>
+    void scan(Table & table, utf8::byte_t const * strm, std::size_t size, std::size_t offset, std::size_t character)
+    {
+        std::size_t const stride = utf8::detail::offset_index::STRIDE;
+        for (; offset < size; ++offset)
+        {
+            // continuation bytes do not start a character
+            if ((strm[offset] & 0xC0) == 0x80)
+                continue;
+            if (!(character % stride))
+                table.push_back(offset);
+            ++character;
+        }
+    }
+}
+
+namespace utf8
+{
+    namespace detail
+    {
+        std::size_t const offset_index::STRIDE;
+
+        offset_index::offset_index()
+            : table_(nullptr)
+        {
+        }
+
+        offset_index::~offset_index()
+        {
+            destroy(table_.load());
+        }
+
+        offset_index::offset_index(offset_index const & src)
+            : table_(nullptr)
+        {
+            if (table_t const * table = src.table_.load(std::memory_order_acquire))
+                table_.store(copy(table, table->get_allocator().resource()));
+        }
+
+        offset_index::offset_index(offset_index const & src, memory_resource * resource)
+            : table_(nullptr)
+        {
+            if (table_t const * table = src.table_.load(std::memory_order_acquire))
+                table_.store(copy(table, resource));
+        }
+
+        offset_index::offset_index(offset_index && src)
+            : table_(src.table_.exchange(nullptr))
+        {
+        }
+
+        offset_index & offset_index::operator = (offset_index const & src)
+        {
+            if (this != &src)
+            {
+                table_t const * table = src.table_.load(std::memory_order_acquire);
+                destroy(table_.exchange(table ? copy(table, table->get_allocator().resource()) : nullptr));
+            }
+            return *this;
+        }
+
+        offset_index & offset_index::operator = (offset_index && src)
+        {
+            if (this != &src)
+                destroy(table_.exchange(src.table_.exchange(nullptr)));
+            return *this;
+        }
+
+        std::size_t offset_index::find(byte_t const * strm, std::size_t size, std::size_t character, memory_resource * resource) const
+        {
+            // short distances are not worth a table
+            if (character < STRIDE)
+                return skip(strm, 0, character);
+
+            table_t * table = table_.load(std::memory_order_acquire);
+            if (!table)
+            {
+                table_t * built = create(resource);
+                try
+                {
+                    built->reserve(size / STRIDE + 1);
+                }
+                catch (...)
+                {
+                    destroy(built);
+                    throw;
+                }
+                scan(*built, strm, size, 0, 0);
+
+                // another thread might have been faster
+                if (table_.compare_exchange_strong(table, built, std::memory_order_acq_rel, std::memory_order_acquire))
+                    table = built;
+                else
+                    destroy(built);
+            }
+
+            return skip(strm, (*table)[character / STRIDE], character % STRIDE);
+        }
+
+        void offset_index::append(byte_t const * strm, std::size_t size, std::size_t offset, std::size_t character)
+        {
+            // appending requires exclusive access anyway, so the table is extended in place
+            if (table_t * table = table_.load(std::memory_order_relaxed))
+                scan(*table, strm, size, offset, character);
+        }
+
+        void offset_index::clear()
+        {
+            destroy(table_.exchange(nullptr));
+        }
+
+        offset_index::table_t * offset_index::create(memory_resource * resource)
+        {
+            void * const memory = resource->allocate(sizeof(table_t), alignof(table_t));
+            return new (memory) table_t(polymorphic_allocator<std::size_t>(resource));
+        }
+
+        offset_index::table_t * offset_index::copy(table_t const * table, memory_resource * resource)
+        {
+            table_t * const copied = create(resource);
+            try
+            {
+                copied->assign(table->begin(), table->end());
+            }
+            catch (...)
+            {
+                destroy(copied);
+                throw;
+            }
+            return copied;
+        }
+
+        void offset_index::destroy(table_t * table)
+        {
+            if (!table)
+                return;
+            memory_resource * const resource = table->get_allocator().resource();
+            table->~table_t();
+            resource->deallocate(table, sizeof(table_t), alignof(table_t));
+        }
+
+        std::size_t offset_index::skip(byte_t const * strm, std::size_t offset, std::size_t characters)
+        {
+            for (; characters; --characters)
+            {
+                byte_t const lead = strm[offset];
+                if (lead < 0x80)
+                    offset += 1;
+                else if (lead < 0xE0)
+                    offset += 2;
+                else if (lead < 0xF0)
+                    offset += 3;
+                else
+                    offset += 4;
+            }
+            return offset;
+        }
+    }
+}
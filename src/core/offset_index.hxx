@@ -0,0 +1,85 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef UTF8PP_CORE_OFFSETINDEX_HXX
+#define UTF8PP_CORE_OFFSETINDEX_HXX
+
+#include "types.hxx"
+#include "memory_resource.hxx"
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+namespace utf8
+{
+    namespace detail
+    {
+        // A sparse table with the byte offset of every STRIDE-th character.
+        // It is built on the first lookup and kept up to date by appends,
+        // so random access costs at most STRIDE steps instead of O(n).
+        // The table is allocated from the memory resource given to find(), the resource
+        // is remembered by the table itself (the index is part of every heap string).
+        class offset_index
+        {
+        public:
+            // number of characters between two checkpoints
+            static std::size_t const STRIDE = 64;
+
+            offset_index();
+            ~offset_index();
+
+            offset_index(offset_index const & src);
+            // copies the table into the given resource
+            offset_index(offset_index const & src, memory_resource * resource);
+            offset_index(offset_index && src);
+            offset_index & operator = (offset_index const & src);
+            offset_index & operator = (offset_index && src);
+
+            // byte offset of the given character in the valid byte stream
+            // the table is built by the first call (safe to call from multiple threads
+            // if the resource is thread safe)
+            std::size_t find(byte_t const * strm, std::size_t size, std::size_t character, memory_resource * resource) const;
+
+            // the bytes [offset, size) starting with the given character were appended
+            void append(byte_t const * strm, std::size_t size, std::size_t offset, std::size_t character);
+
+            // drop the table, e.g. because the byte stream was modified
+            void clear();
+
+            // skips the given number of characters of a valid byte stream
+            static std::size_t skip(byte_t const * strm, std::size_t offset, std::size_t characters);
+
+        private:
+            typedef std::vector<std::size_t, polymorphic_allocator<std::size_t>> table_t;
+
+            // the table and its entries are allocated from the resource
+            static table_t * create(memory_resource * resource);
+            static table_t * copy(table_t const * table, memory_resource * resource);
+            static void destroy(table_t * table);
+
+            // lookups are const but build the table lazily, so it is published atomically
+            mutable std::atomic<table_t *> table_;
+        };
+    }
+}
+
+#endif // UTF8PP_CORE_OFFSETINDEX_HXX
@@ -0,0 +1,454 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "search.hxx"
+#include "decoding.hxx"
+#include "detail.hxx"
+
+#include <algorithm>
+#include <vector>
+
+#include <cstring>
+#include <cstdint>
+
+namespace
+{
+    using utf8::byte_t;
+    using utf8::match;
+    using utf8::detail::count_trailing_zeros;
+
+    // needles up to this size are found by filtering candidates with SIMD, longer ones with Two-Way
+    std::size_t const SHORT_NEEDLE = 32;
+
+#ifdef UTF8PP_SSE2
+    unsigned highest_bit(unsigned mask)
+    {
+#if defined(__GNUC__)
+        return 31 - static_cast<unsigned>(__builtin_clz(mask));
+#else
+        unsigned n = 31;
+        while (!(mask & 0x80000000u))
+            mask <<= 1, --n;
+        return n;
+#endif
+    }
+#endif
+
+    unsigned count_bits(unsigned mask)
+    {
+#if defined(__GNUC__)
+        return static_cast<unsigned>(__builtin_popcount(mask));
+#else
+        unsigned n = 0;
+        for (; mask; mask &= mask - 1)
+            ++n;
+        return n;
+#endif
+    }
+
+    // the needle and haystack seen from the front or from the back,
+    // so Two-Way can search in both directions
+    struct forward_bytes
+    {
+        byte_t const * strm;
+        byte_t operator [] (std::size_t index) const { return strm[index]; }
+    };
+
+    struct backward_bytes
+    {
+        byte_t const * last;
+        byte_t operator [] (std::size_t index) const { return *(last - index); }
+    };
+
+    // maximal suffix of the needle with respect to the normal or the reversed alphabet order
+    template <typename Bytes>
+    std::ptrdiff_t maximal_suffix(Bytes const & needle, std::ptrdiff_t size, bool reversed, std::ptrdiff_t & period)
+    {
+        std::ptrdiff_t suffix = -1, j = 0, k = 1;
+        period = 1;
+        while (j + k < size)
+        {
+            byte_t const a = needle[j + k], b = needle[suffix + k];
+            if (reversed ? a > b : a < b)
+            {
+                j += k;
+                k = 1;
+                period = j - suffix;
+            }
+            else if (a == b)
+            {
+                if (k != period)
+                    ++k;
+                else
+                {
+                    j += period;
+                    k = 1;
+                }
+            }
+            else
+            {
+                suffix = j;
+                j = suffix + 1;
+                k = period = 1;
+            }
+        }
+        return suffix;
+    }
+
+    // Crochemore-Perrin Two-Way string matching: linear time and constant space
+    template <typename Bytes>
+    std::size_t two_way(Bytes const & haystack, std::ptrdiff_t size, Bytes const & needle, std::ptrdiff_t needlesize)
+    {
+        // critical factorization of the needle
+        std::ptrdiff_t p, q;
+        std::ptrdiff_t const i = maximal_suffix(needle, needlesize, false, p);
+        std::ptrdiff_t const j = maximal_suffix(needle, needlesize, true, q);
+        std::ptrdiff_t const critical = i > j ? i : j;
+        std::ptrdiff_t period = i > j ? p : q;
+
+        bool periodic = critical + 1 + period <= needlesize;
+        for (std::ptrdiff_t n = 0; periodic && n <= critical; ++n)
+            periodic = needle[n] == needle[n + period];
+
+        std::ptrdiff_t pos = 0;
+        if (periodic)
+        {
+            // the part left of the critical position matched last time does not need to be compared again
+            std::ptrdiff_t memory = -1;
+            while (pos <= size - needlesize)
+            {
+                std::ptrdiff_t n = std::max(critical, memory) + 1;
+                while (n < needlesize && needle[n] == haystack[pos + n])
+                    ++n;
+                if (n < needlesize)
+                {
+                    pos += n - critical;
+                    memory = -1;
+                    continue;
+                }
+
+                n = critical;
+                while (n > memory && needle[n] == haystack[pos + n])
+                    --n;
+                if (n <= memory)
+                    return static_cast<std::size_t>(pos);
+                pos += period;
+                memory = needlesize - period - 1;
+            }
+        }
+        else
+        {
+            period = std::max(critical + 1, needlesize - critical - 1) + 1;
+            while (pos <= size - needlesize)
+            {
+                std::ptrdiff_t n = critical + 1;
+                while (n < needlesize && needle[n] == haystack[pos + n])
+                    ++n;
+                if (n < needlesize)
+                {
+                    pos += n - critical;
+                    continue;
+                }
+
+                n = critical;
+                while (n >= 0 && needle[n] == haystack[pos + n])
+                    --n;
+                if (n < 0)
+                    return static_cast<std::size_t>(pos);
+                pos += period;
+            }
+        }
+        return match::npos;
+    }
+
+    // compares the first and the last byte of the needle at 16 positions at once
+    // and the rest of the needle only where both of them match
+    std::size_t find_short(byte_t const * strm, std::size_t size, byte_t const * needle, std::size_t needlesize, std::size_t pos)
+    {
+        std::size_t const last = needlesize - 1;
+#ifdef UTF8PP_SSE2
+        __m128i const first_byte = _mm_set1_epi8(static_cast<char>(needle[0]));
+        __m128i const last_byte = _mm_set1_epi8(static_cast<char>(needle[last]));
+        for (; pos + last + 16 <= size; pos += 16)
+        {
+            __m128i const a = _mm_loadu_si128(reinterpret_cast<__m128i const *>(strm + pos));
+            __m128i const b = _mm_loadu_si128(reinterpret_cast<__m128i const *>(strm + pos + last));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(a, first_byte), _mm_cmpeq_epi8(b, last_byte))));
+            for (; mask; mask &= mask - 1)
+            {
+                std::size_t const candidate = pos + count_trailing_zeros(mask);
+                if (!std::memcmp(strm + candidate + 1, needle + 1, last))
+                    return candidate;
+            }
+        }
+#endif
+        for (; pos + last < size; ++pos)
+        {
+            if (strm[pos] == needle[0] && strm[pos + last] == needle[last] && !std::memcmp(strm + pos + 1, needle + 1, last))
+                return pos;
+        }
+        return match::npos;
+    }
+
+    // the same from the back, end is the position behind the last possible match
+    std::size_t rfind_short(byte_t const * strm, byte_t const * needle, std::size_t needlesize, std::size_t end)
+    {
+        std::size_t const last = needlesize - 1;
+#ifdef UTF8PP_SSE2
+        __m128i const first_byte = _mm_set1_epi8(static_cast<char>(needle[0]));
+        __m128i const last_byte = _mm_set1_epi8(static_cast<char>(needle[last]));
+        for (; end >= 16; end -= 16)
+        {
+            std::size_t const pos = end - 16;
+            __m128i const a = _mm_loadu_si128(reinterpret_cast<__m128i const *>(strm + pos));
+            __m128i const b = _mm_loadu_si128(reinterpret_cast<__m128i const *>(strm + pos + last));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(a, first_byte), _mm_cmpeq_epi8(b, last_byte))));
+            while (mask)
+            {
+                unsigned const bit = highest_bit(mask);
+                if (!std::memcmp(strm + pos + bit + 1, needle + 1, last))
+                    return pos + bit;
+                mask &= ~(1u << bit);
+            }
+        }
+#endif
+        while (end--)
+        {
+            if (strm[end] == needle[0] && strm[end + last] == needle[last] && !std::memcmp(strm + end + 1, needle + 1, last))
+                return end;
+        }
+        return match::npos;
+    }
+
+    // first byte which is one of the given ASCII characters
+    std::size_t find_ascii(byte_t const * strm, std::size_t size, std::vector<byte_t> const & characters, std::size_t pos)
+    {
+#ifdef UTF8PP_SSE2
+        if (characters.size() <= 16)
+        {
+            __m128i sets[16];
+            for (std::size_t n = 0; n < characters.size(); ++n)
+                sets[n] = _mm_set1_epi8(static_cast<char>(characters[n]));
+
+            for (; pos + 16 <= size; pos += 16)
+            {
+                __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(strm + pos));
+                __m128i found = _mm_setzero_si128();
+                for (std::size_t n = 0; n < characters.size(); ++n)
+                    found = _mm_or_si128(found, _mm_cmpeq_epi8(v, sets[n]));
+                unsigned const mask = static_cast<unsigned>(_mm_movemask_epi8(found));
+                if (mask)
+                    return pos + count_trailing_zeros(mask);
+            }
+        }
+#endif
+        bool table[128] = { false };
+        for (byte_t c : characters)
+            table[c] = true;
+        for (; pos < size; ++pos)
+        {
+            if (strm[pos] < 0x80 && table[strm[pos]])
+                return pos;
+        }
+        return match::npos;
+    }
+}
+
+namespace utf8
+{
+    std::size_t const match::npos;
+
+    match::match()
+        : strm_(nullptr)
+        , offset_(npos)
+        , position_(npos)
+    {
+    }
+
+    match::match(byte_t const * strm, std::size_t offset)
+        : strm_(strm)
+        , offset_(offset)
+        , position_(npos)
+    {
+    }
+
+    bool match::found() const
+    {
+        return offset_ != npos;
+    }
+
+    match::operator bool () const
+    {
+        return found();
+    }
+
+    std::size_t match::offset() const
+    {
+        return offset_;
+    }
+
+    std::size_t match::position() const
+    {
+        if (position_ == npos && offset_ != npos)
+            position_ = utf32_length(strm_, offset_);
+        return position_;
+    }
+
+    namespace detail
+    {
+        std::size_t find(byte_t const * strm, std::size_t size, byte_t const * needle, std::size_t needlesize, std::size_t from)
+        {
+            if (from > size || needlesize > size - from)
+                return match::npos;
+            if (!needlesize)
+                return from;
+            if (needlesize == 1)
+            {
+                void const * const found = std::memchr(strm + from, needle[0], size - from);
+                return found ? static_cast<byte_t const *>(found) - strm : match::npos;
+            }
+            if (needlesize <= SHORT_NEEDLE)
+                return find_short(strm, size, needle, needlesize, from);
+
+            forward_bytes const haystack = { strm + from }, pattern = { needle };
+            std::size_t const pos = two_way(haystack, static_cast<std::ptrdiff_t>(size - from),
+                pattern, static_cast<std::ptrdiff_t>(needlesize));
+            return pos == match::npos ? pos : from + pos;
+        }
+
+        std::size_t rfind(byte_t const * strm, std::size_t size, byte_t const * needle, std::size_t needlesize, std::size_t from)
+        {
+            if (needlesize > size)
+                return match::npos;
+            // the last possible start
+            std::size_t const last = std::min(from, size - needlesize);
+            if (!needlesize)
+                return last;
+            if (needlesize <= SHORT_NEEDLE)
+                return rfind_short(strm, needle, needlesize, last + 1);
+
+            // Two-Way on the reversed strings
+            backward_bytes const haystack = { strm + last + needlesize - 1 }, pattern = { needle + needlesize - 1 };
+            std::size_t const pos = two_way(haystack, static_cast<std::ptrdiff_t>(last + needlesize),
+                pattern, static_cast<std::ptrdiff_t>(needlesize));
+            return pos == match::npos ? pos : last - pos;
+        }
+
+        std::size_t find_counting(byte_t const * strm, std::size_t size, byte_t const * needle, std::size_t needlesize, std::size_t from, std::size_t & length)
+        {
+            if (from > size)
+                return match::npos;
+
+            std::size_t pos = from;
+#ifdef UTF8PP_SSE2
+            if (needlesize == 1)
+            {
+                // look for the ASCII character and count the lead bytes in front of it in the same pass
+                __m128i const c = _mm_set1_epi8(static_cast<char>(needle[0]));
+                for (; pos + 16 <= size; pos += 16)
+                {
+                    __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(strm + pos));
+                    unsigned const found = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, c)));
+                    // continuation bytes are -128 to -65 as signed bytes
+                    unsigned const leads = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpgt_epi8(v, _mm_set1_epi8(-65))));
+                    if (found)
+                    {
+                        unsigned const bit = count_trailing_zeros(found);
+                        length += count_bits(leads & ((1u << bit) - 1));
+                        return pos + bit;
+                    }
+                    length += count_bits(leads);
+                }
+            }
+#endif
+            std::size_t const found = find(strm, size, needle, needlesize, pos);
+            length += utf32_length(strm + pos, (found == match::npos ? size : found) - pos);
+            return found;
+        }
+
+        std::size_t count(byte_t const * strm, std::size_t size, byte_t const * needle, std::size_t needlesize)
+        {
+            if (!needlesize)
+                return 0;
+
+            std::size_t result = 0, pos = 0;
+#ifdef UTF8PP_SSE2
+            if (needlesize == 1)
+            {
+                // the byte counters are flushed before they can overflow
+                __m128i const c = _mm_set1_epi8(static_cast<char>(needle[0]));
+                __m128i counter = _mm_setzero_si128();
+                while (pos + 16 <= size)
+                {
+                    __m128i hits = _mm_setzero_si128();
+                    for (unsigned block = 0; block < 255 && pos + 16 <= size; ++block, pos += 16)
+                    {
+                        __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(strm + pos));
+                        hits = _mm_sub_epi8(hits, _mm_cmpeq_epi8(v, c));
+                    }
+                    counter = _mm_add_epi64(counter, _mm_sad_epu8(hits, _mm_setzero_si128()));
+                }
+                std::uint64_t halves[2];
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(halves), counter);
+                result = static_cast<std::size_t>(halves[0] + halves[1]);
+            }
+#endif
+            while ((pos = find(strm, size, needle, needlesize, pos)) != match::npos)
+            {
+                ++result;
+                pos += needlesize;
+            }
+            return result;
+        }
+
+        std::size_t find_first_of(byte_t const * strm, std::size_t size, byte_t const * characters, std::size_t charsize, std::size_t from)
+        {
+            if (from >= size)
+                return match::npos;
+
+            // ASCII characters are looked for all at once
+            std::vector<byte_t> ascii;
+            for (std::size_t pos = 0; pos < charsize; ++pos)
+            {
+                if (characters[pos] < 0x80)
+                    ascii.push_back(characters[pos]);
+            }
+            std::size_t best = ascii.empty() ? match::npos : find_ascii(strm, size, ascii, from);
+
+            // every other character only needs to be looked for in front of the best match so far
+            for (std::size_t pos = 0; pos < charsize; )
+            {
+                std::size_t charlen = 1;
+                while (pos + charlen < charsize && (characters[pos + charlen] & 0xC0) == 0x80)
+                    ++charlen;
+                if (charlen > 1)
+                {
+                    std::size_t const end = best == match::npos ? size : best + charlen - 1;
+                    std::size_t const found = find(strm, std::min(size, end), characters + pos, charlen, from);
+                    if (found != match::npos)
+                        best = found;
+                }
+                pos += charlen;
+            }
+            return best;
+        }
+    }
+}
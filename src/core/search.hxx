@@ -0,0 +1,78 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef UTF8PP_CORE_SEARCH_HXX
+#define UTF8PP_CORE_SEARCH_HXX
+
+#include "types.hxx"
+
+#include <cstddef>
+
+namespace utf8
+{
+    // The result of a search: the byte offset of the match and its character index,
+    // which is only counted if asked for. It refers to the searched bytes, so it
+    // becomes invalid if the searched string changes.
+    class match
+    {
+    public:
+        // nothing found
+        match();
+        match(byte_t const * strm, std::size_t offset);
+
+        bool found() const;
+        explicit operator bool () const;
+
+        // byte offset of the match (npos if nothing was found)
+        std::size_t offset() const;
+        // character index of the match, counted on first use (npos if nothing was found)
+        std::size_t position() const;
+
+        static std::size_t const npos = static_cast<std::size_t>(-1);
+
+    private:
+        byte_t const * strm_;
+        std::size_t offset_;
+        mutable std::size_t position_;
+    };
+
+    namespace detail
+    {
+        // Searches in valid UTF-8 byte streams. As UTF-8 is self-synchronizing, a valid
+        // needle only matches at character boundaries, so the bytes are compared directly.
+        // Offsets are byte offsets, match::npos means nothing was found.
+
+        // first occurrence of the needle starting at or behind from
+        std::size_t find(byte_t const * strm, std::size_t size, byte_t const * needle, std::size_t needlesize, std::size_t from);
+        // last occurrence of the needle starting at or before from
+        std::size_t rfind(byte_t const * strm, std::size_t size, byte_t const * needle, std::size_t needlesize, std::size_t from);
+        // same as find(), but also adds the number of characters in front of the match
+        // (or behind from if nothing was found) to length
+        std::size_t find_counting(byte_t const * strm, std::size_t size, byte_t const * needle, std::size_t needlesize, std::size_t from, std::size_t & length);
+        // number of non-overlapping occurrences of the needle
+        std::size_t count(byte_t const * strm, std::size_t size, byte_t const * needle, std::size_t needlesize);
+        // first character starting at or behind from which is one of the given characters
+        std::size_t find_first_of(byte_t const * strm, std::size_t size, byte_t const * characters, std::size_t charsize, std::size_t from);
+    }
+}
+
+#endif // UTF8PP_CORE_SEARCH_HXX
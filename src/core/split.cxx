@@ -0,0 +1,127 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "split.hxx"
+#include "search.hxx"
+
+#include <stdexcept>
+
+namespace utf8
+{
+    split_range::iterator::iterator()
+        : strm_(nullptr)
+        , size_(0)
+        , delimiter_(nullptr)
+        , delimsize_(0)
+        , start_(match::npos)
+    {
+    }
+
+    split_range::iterator::iterator(string_view const & text, string_view const & delimiter)
+        : strm_(text.bytes())
+        , size_(text.size())
+        , delimiter_(delimiter.bytes())
+        , delimsize_(delimiter.size())
+        , start_(0)
+    {
+        scan();
+    }
+
+    void split_range::iterator::scan()
+    {
+        std::size_t length = 0;
+        std::size_t const found = detail::find_counting(strm_, size_, delimiter_, delimsize_, start_, length);
+        std::size_t const end = found == match::npos ? size_ : found;
+        field_ = string_view(strm_ + start_, end - start_, length);
+    }
+
+    bool split_range::iterator::operator == (iterator const & rhs) const
+    {
+        return start_ == rhs.start_;
+    }
+
+    bool split_range::iterator::operator != (iterator const & rhs) const
+    {
+        return start_ != rhs.start_;
+    }
+
+    split_range::iterator split_range::iterator::operator ++ (int)
+    {
+        iterator tmp(*this);
+        ++*this;
+        return tmp;
+    }
+
+    split_range::iterator & split_range::iterator::operator ++ ()
+    {
+        std::size_t const end = start_ + field_.size();
+        if (end == size_)
+        {
+            // that was the last field
+            start_ = match::npos;
+            field_ = string_view();
+            return *this;
+        }
+
+        start_ = end + delimsize_;
+        scan();
+        return *this;
+    }
+
+    string_view const & split_range::iterator::operator * () const
+    {
+        return field_;
+    }
+
+    string_view const * split_range::iterator::operator -> () const
+    {
+        return &field_;
+    }
+
+    split_range::split_range(string_view const & text, string_view const & delimiter)
+        : text_(text)
+        , delimiter_(delimiter)
+    {
+        // validate both once, the fields are slices of them
+        text_.require_valid();
+        delimiter_.require_valid();
+        if (delimiter_.empty())
+            throw std::invalid_argument("Delimiter is empty.");
+    }
+
+    split_range::iterator split_range::begin() const
+    {
+        return iterator(text_, delimiter_);
+    }
+
+    split_range::iterator split_range::end() const
+    {
+        return iterator();
+    }
+
+    split_range split(string_view const & text, string_view const & delimiter)
+    {
+        return split_range(text, delimiter);
+    }
+
+    split_range split(mapped_file const & file, string_view const & delimiter)
+    {
+        return split_range(file.view(), delimiter);
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef UTF8PP_CORE_SPLIT_HXX
+#define UTF8PP_CORE_SPLIT_HXX
+
+#include "types.hxx"
+#include "string_view.hxx"
+#include "mapped_file.hxx"
+
+#include <iterator>
+#include <cstddef>
+
+namespace utf8
+{
+    // The fields of a text separated by a delimiter, found one at a time while iterating.
+    // The fields are views of the text, which is validated once, so they need no validation
+    // and their lengths are counted while looking for the next delimiter.
+    // Just like views, the range must not outlive the text it was created from.
+    class split_range
+    {
+    public:
+        class iterator
+        {
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef string_view value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef string_view const * pointer;
+            typedef string_view const & reference;
+
+            iterator();
+
+            bool operator == (iterator const & rhs) const;
+            bool operator != (iterator const & rhs) const;
+
+            iterator operator ++ (int);
+            iterator & operator ++ ();
+
+            string_view const & operator * () const;
+            string_view const * operator -> () const;
+
+        private:
+            iterator(string_view const & text, string_view const & delimiter);
+
+            // finds the field starting at start_
+            void scan();
+
+            byte_t const * strm_;
+            std::size_t size_;
+            byte_t const * delimiter_;
+            std::size_t delimsize_;
+
+            // byte offset of the current field (npos behind the last one)
+            std::size_t start_;
+            string_view field_;
+
+            friend class split_range;
+        };
+
+        // This constructor will throw an std::invalid_argument exception
+        // if the text or the delimiter are not valid UTF-8 or the delimiter is empty.
+        split_range(string_view const & text, string_view const & delimiter);
+
+        iterator begin() const;
+        iterator end() const;
+
+    private:
+        string_view text_;
+        string_view delimiter_;
+    };
+
+    // Splits the text at every occurrence of the delimiter, like "a,,b" -> "a", "", "b".
+    // A text without delimiter is a single field, even if it is empty.
+    split_range split(string_view const & text, string_view const & delimiter);
+    split_range split(mapped_file const & file, string_view const & delimiter);
+}
+
+#endif // UTF8PP_CORE_SPLIT_HXX
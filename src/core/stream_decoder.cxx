@@ -0,0 +1,185 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream_decoder.hxx"
+#include "validation.hxx"
+
+#include <algorithm>
+
+#include <cstring>
+
+namespace
+{
+    using utf8::byte_t;
+
+    // length of the sequence started by a lead byte
+    unsigned expected_length(byte_t lead)
+    {
+        return lead < 0xE0 ? 2 : (lead < 0xF0 ? 3 : 4);
+    }
+
+    // true if the bytes start a well-formed sequence that needs more bytes
+    bool is_incomplete(byte_t const * strm, std::size_t size)
+    {
+        if (size == 1)
+            return strm[0] >= 0xC2 && strm[0] <= 0xF4;
+
+        // the missing bytes are filled with continuation bytes
+        byte_t buffer[4] = { 0x80, 0x80, 0x80, 0x80 };
+        std::memcpy(buffer, strm, size);
+        return utf8::detail::sequence_length(buffer, 4) > size;
+    }
+
+    // number of bytes of an incomplete sequence at the end of the chunk
+    std::size_t incomplete_tail(byte_t const * strm, std::size_t size)
+    {
+        for (std::size_t tail = 1; tail <= std::min<std::size_t>(3, size); ++tail)
+        {
+            byte_t const byte = strm[size - tail];
+            if ((byte & 0xC0) == 0x80)
+                continue;
+
+            // malformed tails are left to the validation of the chunk
+            if (byte >= 0xC0 && expected_length(byte) > tail && is_incomplete(strm + size - tail, tail))
+                return tail;
+            return 0;
+        }
+        return 0;
+    }
+}
+
+namespace utf8
+{
+    stream_decoder::stream_decoder()
+    {
+        reset();
+    }
+
+    void stream_decoder::reset()
+    {
+        carried_ = 0;
+        failed_ = false;
+        length_ = 0;
+        position_ = 0;
+        error_ = 0;
+    }
+
+    stream_decoder::chunk_result stream_decoder::fail(std::uint64_t offset)
+    {
+        failed_ = true;
+        error_ = offset;
+        chunk_result result = { false, 0, offset };
+        return result;
+    }
+
+    stream_decoder::chunk_result stream_decoder::feed(char const * str, std::size_t size)
+    {
+        return feed(reinterpret_cast<byte_t const *>(str), size);
+    }
+
+    stream_decoder::chunk_result stream_decoder::feed(byte_t const * strm, std::size_t size)
+    {
+        if (failed_)
+        {
+            chunk_result result = { false, 0, error_ };
+            return result;
+        }
+
+        chunk_result result = { true, 0, 0 };
+        std::size_t pos = 0;
+
+        // complete the sequence carried over from the last chunk
+        if (carried_)
+        {
+            std::uint64_t const start = position_ - carried_;
+            unsigned const needed = expected_length(carry_[0]);
+            byte_t sequence[4];
+            std::memcpy(sequence, carry_, carried_);
+            pos = std::min<std::size_t>(needed - carried_, size);
+            if (pos)
+                std::memcpy(sequence + carried_, strm, pos);
+            position_ += pos;
+
+            if (carried_ + pos < needed)
+            {
+                // still incomplete
+                if (!is_incomplete(sequence, carried_ + pos))
+                    return fail(start);
+                std::memcpy(carry_, sequence, carried_ + pos);
+                carried_ += static_cast<unsigned>(pos);
+                return result;
+            }
+
+            if (detail::sequence_length(sequence, needed) != needed)
+                return fail(start);
+            carried_ = 0;
+            ++length_;
+            result.length = 1;
+        }
+
+        // validate everything up to an incomplete sequence at the end
+        std::size_t const tail = incomplete_tail(strm + pos, size - pos);
+        std::size_t const body = size - pos - tail;
+        detail::validation_result const validation = detail::validate(strm + pos, body);
+        if (!validation.valid)
+            return fail(position_ + validation.offset);
+
+        if (tail)
+            std::memcpy(carry_, strm + pos + body, tail);
+        carried_ = static_cast<unsigned>(tail);
+        position_ += body + tail;
+        length_ += validation.length;
+        result.length += validation.length;
+        return result;
+    }
+
+    stream_decoder::chunk_result stream_decoder::finish()
+    {
+        if (failed_)
+        {
+            chunk_result result = { false, 0, error_ };
+            return result;
+        }
+        if (carried_)
+            return fail(position_ - carried_);
+
+        chunk_result result = { true, 0, 0 };
+        return result;
+    }
+
+    bool stream_decoder::failed() const
+    {
+        return failed_;
+    }
+
+    std::uint64_t stream_decoder::length() const
+    {
+        return length_;
+    }
+
+    std::uint64_t stream_decoder::position() const
+    {
+        return position_;
+    }
+
+    unsigned stream_decoder::carried() const
+    {
+        return carried_;
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef UTF8PP_CORE_STREAMDECODER_HXX
+#define UTF8PP_CORE_STREAMDECODER_HXX
+
+#include "types.hxx"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace utf8
+{
+    // Validates and counts a byte stream arriving in chunks of any size.
+    // Sequences split between chunks are carried over (at most 3 bytes),
+    // so the memory use does not depend on the size of the stream.
+    // Once an invalid sequence has been found, the decoder stays failed until reset().
+    // NOTE: unlike utf8::string the stream may contain NULL bytes
+    class stream_decoder
+    {
+    public:
+        // the result of a single chunk
+        struct chunk_result
+        {
+            // false if the stream is invalid up to the end of this chunk
+            bool valid;
+            // number of characters completed by this chunk
+            std::size_t length;
+            // stream offset of the first invalid sequence (only set if not valid)
+            std::uint64_t offset;
+        };
+
+        stream_decoder();
+
+        // validates the next chunk of the stream
+        chunk_result feed(byte_t const * strm, std::size_t size);
+        chunk_result feed(char const * str, std::size_t size);
+        // ends the stream, a carried over sequence can't be completed anymore
+        chunk_result finish();
+        // starts a new stream
+        void reset();
+
+        // true if an invalid sequence has been found
+        bool failed() const;
+        // number of characters and bytes of the stream so far
+        std::uint64_t length() const;
+        std::uint64_t position() const;
+        // bytes of an unfinished sequence at the end of the last chunk
+        unsigned carried() const;
+
+    private:
+        chunk_result fail(std::uint64_t offset);
+
+        byte_t carry_[3];
+        unsigned carried_;
+        bool failed_;
+        std::uint64_t length_;
+        std::uint64_t position_;
+        std::uint64_t error_;
+    };
+}
+
+#endif // UTF8PP_CORE_STREAMDECODER_HXX
@@ -18,244 +18,687 @@
 */
 
 #include "string.hxx"
+#include "string_view.hxx"
+#include "validation.hxx"
+#include "encoding.hxx"
+#include "hash.hxx"
 
 #include <algorithm>
+#include <functional>
 #include <stdexcept>
 #include <iostream>
 #include <iterator>
+#include <new>
 
 #include <cstring>
-#include <cmath>
 
 namespace
 {
-    // calculates the next UTF-8 character of the input byte stream
-    // safe version -> checks for invalid characters
-    utf8::value_t next_s(utf8::byte_t const * strm = nullptr, unsigned length = -1)
+    // marks short strings in string::length_
+    std::size_t const SHORT_FLAG = ~(~std::size_t(0) >> 1);
+    // the two bits below hold the maximum character width minus one
+    unsigned const WIDTH_SHIFT = sizeof(std::size_t) * 8 - 3;
+    std::size_t const WIDTH_MASK = std::size_t(3) << WIDTH_SHIFT;
+}
+
+namespace utf8
+{
+    std::size_t const string::SHORT_CAPACITY;
+
+    string::heap_storage::heap_storage(storage_type && bytes)
+        : bytes(std::move(bytes))
     {
-        static utf8::byte_t const * ptr = nullptr;
-        static unsigned len = 0;
-        if (strm)
+    }
+
+    string::heap_storage::heap_storage(storage_type && bytes, detail::offset_index const & index)
+        : bytes(std::move(bytes))
+        , index(index, this->bytes.get_allocator().resource())
+    {
+    }
+
+    string::string(char const * str /* = nullptr */, memory_resource * resource /* = nullptr */)
+        : length_(SHORT_FLAG)
+    {
+        local_.resource = resource_or_default(resource);
+        if (str)
         {
-            ptr = strm;
-            len = length;
-        }
+            // calculate buffer size
+            std::size_t bufflen = std::strlen(str);
+
+            // calculate length of string
+            detail::validation_result result = detail::validate(reinterpret_cast<byte_t const *>(str), bufflen);
+
+            // error handling
+            if (!result.valid)
+                throw std::invalid_argument("String contains non UTF-8 bytes.");
 
-        // end of string
-        if (!len)
-            return utf8::END_OF_STRING;
+            // copy string
+            append_bytes(reinterpret_cast<byte_t const *>(str), bufflen, result.length, result.width);
+        }
+    }
 
-        utf8::value_t result;
-        unsigned charlen;
+    string::~string()
+    {
+        if (!is_short())
+            heap_.~heap_storage();
+    }
 
-        // single byte character
-        if (!(ptr[0] & 0x80))
+    string::string(string const & src, memory_resource * resource /* = nullptr */)
+        : length_(src.length_)
+    {
+        resource = resource_or_default(resource);
+        if (src.is_short())
         {
-            charlen = 1;
-            result = ptr[0] & 0x7F;
+            std::memcpy(local_.bytes, src.local_.bytes, SHORT_CAPACITY);
+            local_.resource = resource;
         }
         else
+            new (&heap_) heap_storage(storage_type(src.heap_.bytes, allocator_type(resource)), src.heap_.index);
+    }
+
+    string & string::operator = (string const & src)
+    {
+        if (this != &src)
         {
-            utf8::byte_t mask;
-            // determine the byte length of the character
-            if ((ptr[0] & 0xE0) == 0xC0)
-                charlen = 2, mask = 0x1F;
-            else if ((ptr[0] & 0xF0) == 0xE0)
-                charlen = 3, mask = 0x0F;
-            else if ((ptr[0] & 0xF8) == 0xF0)
-                charlen = 4, mask = 0x07;
+            // the copy is made with our resource, so its storage can be taken over
+            string tmp(src, resource());
+            reset();
+            if (tmp.is_short())
+                local_ = tmp.local_;
             else
-                return utf8::INVALID_CHARACTER;
+                new (&heap_) heap_storage(std::move(tmp.heap_));
+            length_ = tmp.length_;
+        }
+        return *this;
+    }
 
-            // character would need more bytes than available
-            if (charlen > len)
-                return utf8::INVALID_CHARACTER;
+    string & string::operator = (string && src)
+    {
+        if (this != &src)
+        {
+            memory_resource * const resource = this->resource();
+            if (resource != src.resource() && !resource->is_equal(*src.resource()))
+                return *this = static_cast<string const &>(src);
 
-            // calculate the unicode index
-            result = ptr[0] & mask;
-            for (unsigned byte = 1; byte < charlen; ++byte)
+            reset();
+            if (src.is_short())
             {
-                utf8::byte_t cb = ptr[byte];
-                if ((cb & 0xC0) != 0x80)
-                    return utf8::INVALID_CHARACTER;
-                result = (result << 6) | (cb & 0x3F);
+                local_ = src.local_;
+                local_.resource = resource;
             }
+            else
+                new (&heap_) heap_storage(std::move(src.heap_));
+            length_ = src.length_;
+            src.reset();
         }
-        // increment ptr and decrement len
-        ptr += charlen;
-        len -= charlen;
+        return *this;
+    }
 
-        return result;
+    string::string(std::string const & src, memory_resource * resource /* = nullptr */)
+        : length_(SHORT_FLAG)
+    {
+        local_.resource = resource_or_default(resource);
+
+        // unlike a C string the std::string might contain NULL bytes
+        byte_t const * strm = reinterpret_cast<byte_t const *>(src.data());
+        detail::validation_result result = detail::validate(strm, src.size(), detail::nul_bytes::reject);
+
+        // error handling
+        if (!result.valid)
+            throw std::invalid_argument("String contains non UTF-8 bytes.");
+
+        append_bytes(strm, src.size(), result.length, result.width);
     }
-}
 
-namespace utf8
-{
-    string::string(char const * str /* = nullptr */)
-        : length_(0)
+    string::string(string_view const & src, memory_resource * resource /* = nullptr */)
+        : length_(SHORT_FLAG)
     {
-        if (str)
-        {
-            // calculate buffer size
-            unsigned bufflen = static_cast<unsigned>(std::strlen(str));
+        local_.resource = resource_or_default(resource);
+        append(src);
+    }
 
-            // calculate length of string
-            value_t val = ::next_s(reinterpret_cast<byte_t const *>(str), bufflen);
-            while ((val != INVALID_CHARACTER) && (val != END_OF_STRING))
-            {
-                ++length_;
-                val = ::next_s();
-            }
+    string::string(char const * src, replace_invalid_t, memory_resource * resource /* = nullptr */)
+        : length_(SHORT_FLAG)
+    {
+        local_.resource = resource_or_default(resource);
+        assign_lossy(reinterpret_cast<byte_t const *>(src), src ? std::strlen(src) : 0, true);
+    }
 
-            // error handling
-            if (val == INVALID_CHARACTER)
-                throw std::invalid_argument("String contains non UTF-8 bytes.");
+    string::string(std::string const & src, replace_invalid_t, memory_resource * resource /* = nullptr */)
+        : length_(SHORT_FLAG)
+    {
+        local_.resource = resource_or_default(resource);
+        assign_lossy(reinterpret_cast<byte_t const *>(src.data()), src.size(), true);
+    }
 
-            // copy string
-            data_.resize(bufflen);
-            std::memcpy(&(data_[0]), str, bufflen);
-        }
+    string::string(string_view const & src, replace_invalid_t, memory_resource * resource /* = nullptr */)
+        : length_(SHORT_FLAG)
+    {
+        local_.resource = resource_or_default(resource);
+        assign_lossy(src.bytes(), src.size(), true);
     }
 
-    string::~string() = default;
-    string::string (string const & src) = default;
-    string & string::operator = (string const & src) = default;
+    string::string(char const * src, skip_invalid_t, memory_resource * resource /* = nullptr */)
+        : length_(SHORT_FLAG)
+    {
+        local_.resource = resource_or_default(resource);
+        assign_lossy(reinterpret_cast<byte_t const *>(src), src ? std::strlen(src) : 0, false);
+    }
 
-    string::string(std::string const & src)
-        : length_(0)
-        , data_(std::begin(src), std::end(src))
+    string::string(std::string const & src, skip_invalid_t, memory_resource * resource /* = nullptr */)
+        : length_(SHORT_FLAG)
     {
-        unsigned bufflen = static_cast<unsigned>(data_.size());
-        value_t val = ::next_s(&(data_[0]), bufflen);
-        while ((val != INVALID_CHARACTER) && (val != END_OF_STRING))
-        {
-            ++length_;
-            val = ::next_s();
-        }
+        local_.resource = resource_or_default(resource);
+        assign_lossy(reinterpret_cast<byte_t const *>(src.data()), src.size(), false);
+    }
 
-        // error handling
-        if (val == INVALID_CHARACTER)
-            throw std::invalid_argument("String contains non UTF-8 bytes.");
+    string::string(string_view const & src, skip_invalid_t, memory_resource * resource /* = nullptr */)
+        : length_(SHORT_FLAG)
+    {
+        local_.resource = resource_or_default(resource);
+        assign_lossy(src.bytes(), src.size(), false);
+    }
+
+    string::string(char const * src, check_result & result, memory_resource * resource /* = nullptr */) noexcept
+        : length_(SHORT_FLAG)
+    {
+        local_.resource = resource_or_default(resource);
+        result = assign_checked(reinterpret_cast<byte_t const *>(src), src ? std::strlen(src) : 0);
+    }
+
+    string::string(std::string const & src, check_result & result, memory_resource * resource /* = nullptr */) noexcept
+        : length_(SHORT_FLAG)
+    {
+        local_.resource = resource_or_default(resource);
+        result = assign_checked(reinterpret_cast<byte_t const *>(src.data()), src.size());
+    }
+
+    string::string(string_view const & src, check_result & result, memory_resource * resource /* = nullptr */) noexcept
+        : length_(SHORT_FLAG)
+    {
+        local_.resource = resource_or_default(resource);
+        result = assign_checked(src.bytes(), src.size());
     }
 
     // move constructor
     string::string(string && src)
         : length_(src.length_)
     {
-        data_.swap(src.data_);
+        if (src.is_short())
+            local_ = src.local_;
+        else
+            new (&heap_) heap_storage(std::move(src.heap_));
+        src.reset();
+    }
+
+    bool string::is_short() const
+    {
+        return (length_ & SHORT_FLAG) != 0;
+    }
+
+    void string::set_short(std::size_t size, std::size_t length)
+    {
+        length_ = SHORT_FLAG | (length_ & WIDTH_MASK) | (size << 8) | length;
+    }
+
+    void string::set_length(std::size_t length)
+    {
+        length_ = (length_ & WIDTH_MASK) | length;
+    }
+
+    void string::widen(unsigned width)
+    {
+        if (width > max_width())
+            length_ = (length_ & ~WIDTH_MASK) | (std::size_t(width - 1) << WIDTH_SHIFT);
+    }
+
+    void string::reset()
+    {
+        if (!is_short())
+        {
+            memory_resource * const resource = this->resource();
+            heap_.~heap_storage();
+            local_.resource = resource;
+        }
+        length_ = SHORT_FLAG;
+    }
+
+    void string::spill()
+    {
+        if (!is_short())
+            return;
+
+        storage_type bytes(local_.bytes, local_.bytes + size(), allocator_type(local_.resource));
+        std::size_t const length = this->length();
+        new (&heap_) heap_storage(std::move(bytes));
+        length_ = (length_ & WIDTH_MASK) | length;
+    }
+
+    void string::append_bytes(byte_t const * strm, std::size_t size, std::size_t length, unsigned width)
+    {
+        // an empty heap string has no buffer, memcpy must not get the null pointer
+        if (!size)
+            return;
+
+        std::size_t const oldsize = this->size(), oldlength = this->length();
+        std::memcpy(grow(size), strm, size);
+        grown(oldsize, oldlength, length, width);
+    }
+
+    byte_t * string::grow(std::size_t size)
+    {
+        std::size_t const oldsize = this->size();
+        if (is_short())
+        {
+            if (oldsize + size <= SHORT_CAPACITY)
+            {
+                set_short(oldsize + size, length());
+                return local_.bytes + oldsize;
+            }
+
+            storage_type bytes{allocator_type(local_.resource)};
+            bytes.reserve(oldsize + size);
+            bytes.assign(local_.bytes, local_.bytes + oldsize);
+            std::size_t const length = this->length();
+            new (&heap_) heap_storage(std::move(bytes));
+            set_length(length);
+        }
+        heap_.bytes.resize(oldsize + size);
+        return heap_.bytes.data() + oldsize;
+    }
+
+    void string::grown(std::size_t oldsize, std::size_t oldlength, std::size_t length, unsigned width)
+    {
+        if (is_short())
+            set_short(size(), oldlength + length);
+        else
+        {
+            heap_.index.append(heap_.bytes.data(), heap_.bytes.size(), oldsize, oldlength);
+            set_length(oldlength + length);
+        }
+        if (length)
+            widen(width);
     }
 
     std::size_t string::length() const
     {
-        return length_;
+        return is_short() ? (length_ & 0xFF) : (length_ & ~WIDTH_MASK);
     }
 
-    std::vector<byte_t> const & string::data() const
+    bool string::is_ascii() const
     {
-        return data_;
+        // valid UTF-8 has multi byte characters otherwise
+        return length() == size();
     }
 
-    std::vector<byte_t> & string::data()
+    unsigned string::max_width() const
     {
-        return data_;
+        return length() ? static_cast<unsigned>((length_ & WIDTH_MASK) >> WIDTH_SHIFT) + 1 : 0;
     }
-    
+
+    byte_t const * string::bytes() const
+    {
+        return is_short() ? local_.bytes : heap_.bytes.data();
+    }
+
     std::size_t string::size() const
     {
-        return data_.size();
+        return is_short() ? ((length_ >> 8) & 0xFF) : heap_.bytes.size();
+    }
+
+    std::size_t string::capacity() const
+    {
+        return is_short() ? SHORT_CAPACITY : heap_.bytes.capacity();
+    }
+
+    void string::reserve(std::size_t size)
+    {
+        if (size <= capacity())
+            return;
+
+        if (is_short())
+        {
+            storage_type bytes{allocator_type(local_.resource)};
+            bytes.reserve(size);
+            bytes.assign(local_.bytes, local_.bytes + this->size());
+            std::size_t const length = this->length();
+            new (&heap_) heap_storage(std::move(bytes));
+            set_length(length);
+        }
+        else
+            heap_.bytes.reserve(size);
+    }
+
+    memory_resource * string::resource() const
+    {
+        return is_short() ? local_.resource : heap_.bytes.get_allocator().resource();
+    }
+
+    string::allocator_type string::get_allocator() const
+    {
+        return allocator_type(resource());
+    }
+
+    string::storage_type & string::data()
+    {
+        spill();
+        // the caller might change the bytes (and their widths)
+        heap_.index.clear();
+        if (length())
+            widen(4);
+        return heap_.bytes;
     }
 
     string::const_iterator string::begin() const
     {
-        return const_iterator(&(data_[0]), static_cast<unsigned>(data_.size()));
+        return const_iterator(this, bytes(), bytes() + size(), bytes(), 0);
     }
 
     string::const_iterator string::end() const
     {
-        return const_iterator();
+        return const_iterator(this, bytes(), bytes() + size(), bytes() + size(), length());
+    }
+
+    string::const_reverse_iterator string::rbegin() const
+    {
+        return const_reverse_iterator(end());
+    }
+
+    string::const_reverse_iterator string::rend() const
+    {
+        return const_reverse_iterator(begin());
     }
 
     value_t string::operator [] (unsigned index) const
     {
-        if (index > length_)
+        if (index >= length())
             throw std::range_error("Index is too big.");
-        return *(begin() + index);
+
+        if (is_ascii())
+            return bytes()[index];
+
+        std::size_t const byte = offset(index);
+        return *const_iterator(this, bytes(), bytes() + size(), bytes() + byte, index);
+    }
+
+    match string::find(value_t c, std::size_t from /* = 0 */) const
+    {
+        return string_view(*this).find(c, from);
+    }
+
+    match string::find(string_view const & needle, std::size_t from /* = 0 */) const
+    {
+        return string_view(*this).find(needle, from);
+    }
+
+    match string::rfind(value_t c, std::size_t from /* = match::npos */) const
+    {
+        return string_view(*this).rfind(c, from);
+    }
+
+    match string::rfind(string_view const & needle, std::size_t from /* = match::npos */) const
+    {
+        return string_view(*this).rfind(needle, from);
+    }
+
+    match string::find_first_of(string_view const & characters, std::size_t from /* = 0 */) const
+    {
+        return string_view(*this).find_first_of(characters, from);
+    }
+
+    std::size_t string::count(value_t c) const
+    {
+        return string_view(*this).count(c);
+    }
+
+    std::size_t string::count(string_view const & needle) const
+    {
+        return string_view(*this).count(needle);
+    }
+
+    bool string::contains(value_t c) const
+    {
+        return string_view(*this).contains(c);
+    }
+
+    bool string::contains(string_view const & needle) const
+    {
+        return string_view(*this).contains(needle);
+    }
+
+    std::size_t string::offset(std::size_t character) const
+    {
+        if (is_ascii())
+            return character;
+        if (is_short())
+            return detail::offset_index::skip(local_.bytes, 0, character);
+        return heap_.index.find(heap_.bytes.data(), heap_.bytes.size(), character, heap_.bytes.get_allocator().resource());
+    }
+
+    void string::assign_lossy(byte_t const * strm, std::size_t size, bool replacement)
+    {
+        static byte_t const REPLACEMENT_CHARACTER[] = { 0xEF, 0xBF, 0xBD };
+
+        // The output is written in place: room for the whole input is made up front
+        // (replacements of single bytes may need more later) and cut to size at the end.
+        std::size_t const oldsize = this->size(), oldlength = this->length();
+        std::size_t capacity = size, written = 0, length = 0;
+        unsigned width = 0;
+        byte_t * out = grow(capacity);
+
+        // validate up to the next error, copy the valid part and continue behind the error
+        // (only the first pass may be split between threads, so dense errors don't spawn threads over and over)
+        std::size_t pos = 0;
+        while (pos < size)
+        {
+            detail::validation_result const result = pos
+                ? detail::validate(strm + pos, size - pos, detail::best_validation_kernel(), detail::nul_bytes::reject)
+                : detail::validate(strm, size, detail::nul_bytes::reject);
+
+            std::memcpy(out + written, strm + pos, result.offset);
+            written += result.offset;
+            length += result.length;
+            width = std::max(width, result.width);
+            pos += result.offset;
+            if (pos == size)
+                break;
+
+            pos += detail::maximal_subpart(strm + pos, size - pos);
+            if (replacement)
+            {
+                // the rest of the input plus the replacement has to fit
+                std::size_t const needed = written + sizeof(REPLACEMENT_CHARACTER) + (size - pos);
+                if (needed > capacity)
+                {
+                    out = grow(needed - capacity) - capacity;
+                    capacity = needed;
+                }
+                std::memcpy(out + written, REPLACEMENT_CHARACTER, sizeof(REPLACEMENT_CHARACTER));
+                written += sizeof(REPLACEMENT_CHARACTER);
+                ++length;
+                width = std::max(width, 3u);
+            }
+        }
+
+        if (is_short())
+            set_short(oldsize + written, oldlength);
+        else
+            heap_.bytes.resize(oldsize + written);
+        grown(oldsize, oldlength, length, width);
+    }
+
+    check_result string::assign_checked(byte_t const * strm, std::size_t size) noexcept
+    {
+        check_result result = { check_result::error::no_memory, 0 };
+        try
+        {
+            detail::validation_result const valid = detail::validate(strm, size, detail::nul_bytes::reject);
+
+            result.offset = valid.offset;
+            if (!valid.valid)
+                result.status = check_result::error::invalid;
+            else
+            {
+                // stays no_memory if the resource throws
+                append_bytes(strm, size, valid.length, valid.width);
+                result.status = check_result::error::none;
+            }
+        }
+        catch (...)
+        {
+            // the resource (or the validation threads) failed, the string stays empty
+            reset();
+        }
+        return result;
+    }
+
+    int string::compare(string const & other) const
+    {
+        return string_view(*this).compare(other);
+    }
+
+    bool operator == (string const & lhs, string const & rhs)
+    {
+        return lhs.size() == rhs.size() && lhs.length() == rhs.length() && !std::memcmp(lhs.bytes(), rhs.bytes(), lhs.size());
+    }
+
+    bool operator != (string const & lhs, string const & rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    bool operator < (string const & lhs, string const & rhs)
+    {
+        return lhs.compare(rhs) < 0;
+    }
+
+    bool operator <= (string const & lhs, string const & rhs)
+    {
+        return lhs.compare(rhs) <= 0;
+    }
+
+    bool operator > (string const & lhs, string const & rhs)
+    {
+        return lhs.compare(rhs) > 0;
+    }
+
+    bool operator >= (string const & lhs, string const & rhs)
+    {
+        return lhs.compare(rhs) >= 0;
     }
 
     string string::operator + (string const & other) const
     {
-        string cpy(*this);
-        cpy += other;
-        return cpy;
+        // a single allocation for both
+        string result(nullptr, resource());
+        result.reserve(size() + other.size());
+        result += *this;
+        result += other;
+        return result;
+    }
+
+    string operator + (string && lhs, string const & rhs)
+    {
+        lhs += rhs;
+        return std::move(lhs);
     }
 
     string & string::operator += (string const & other)
     {
-        unsigned oldsize = static_cast<unsigned>(data_.size());
-        length_ += other.length_;
-        data_.resize(data_.size() + other.data_.size());
-        std::memcpy(&(data_[oldsize]), &(other.data_[0]), other.data_.size());
+        // appending a string to itself would read from the buffer being reallocated
+        if (this == &other)
+        {
+            string const cpy(other, resource());
+            append_bytes(cpy.bytes(), cpy.size(), cpy.length(), cpy.max_width());
+        }
+        else
+            append_bytes(other.bytes(), other.size(), other.length(), other.max_width());
         return *this;
     }
     
+    string & string::append(string_view const & str)
+    {
+        // a view of the string itself would read from the buffer being reallocated
+        std::less<byte_t const *> const before;
+        if (!before(str.bytes(), bytes()) && before(str.bytes(), bytes() + size()))
+            return *this += string(str, resource());
+
+        std::size_t const length = str.length();
+        append_bytes(str.bytes(), str.size(), length, str.is_ascii() ? 1 : detail::max_width(str.bytes(), str.size()));
+        return *this;
+    }
+
     void string::push_back(value_t c)
     {
-        unsigned numbits = static_cast<unsigned>(std::ceil(std::log2(c)));
-        if (numbits > 21)
+        unsigned const numbytes = detail::encoded_size(c);
+        if (!numbytes)
             throw std::invalid_argument("c is not a valid Unicode character.");
-        
-        unsigned numbytes = 0; // number of UTF-8 Bytes
-        if (numbits <= 7)
-            numbytes = 1;
-        else if (numbits > 7 && numbits <= 11)
-            numbytes = 2;
-        else if (numbits > 11 && numbits <= 16)
-            numbytes = 3;
-        else
-            numbytes = 4;
-        
-        if (!numbytes) // no null-bytes in utf8::string
+
+        if (!c) // no null-bytes in utf8::string
             return;
-        
-        std::vector<byte_t> character(numbytes);
-        
-        for (unsigned byte = numbytes - 1; byte >= 1; --byte)
-        {
-            character[byte] = 0x80 | (c & 0x3F);
-            c >>= 6;
-        }
-        
-        switch (numbytes)
-        {
-            case 1: character[0] = c & 0x7F; break;
-            case 2: character[0] = 0xC0 | (c & 0x1F); break;
-            case 3: character[0] = 0xE0 | (c & 0x0F); break;
-            case 4: character[0] = 0xF0 | (c & 0x07); break;
-        }
-        
+
+        byte_t character[4];
+        detail::encode(c, character);
+
         // append the new character
-        data_.insert(data_.end(), character.begin(), character.end());
-        ++length_;
+        append_bytes(character, numbytes, 1, numbytes);
+    }
+
+    template <typename CodeUnit>
+    string & string::append_units(CodeUnit const * str, std::size_t size)
+    {
+        // the first pass checks the characters and sizes the output
+        std::size_t length = 0;
+        std::size_t const numbytes = detail::encoded_size(str, size, length);
+
+        std::size_t const oldsize = this->size(), oldlength = this->length();
+        byte_t * const out = grow(numbytes);
+        detail::encode(str, size, out);
+        grown(oldsize, oldlength, length, length == numbytes ? 1 : detail::max_width(out, numbytes));
+        return *this;
+    }
+
+    string & string::append(char32_t const * str, std::size_t size)
+    {
+        return append_units(str, size);
+    }
+
+    string & string::append(char16_t const * str, std::size_t size)
+    {
+        return append_units(str, size);
+    }
+
+    string & string::append(wchar_t const * str, std::size_t size)
+    {
+        return append_units(str, size);
     }
 
     std::istream & getline(std::istream & is, string & str, char delim /* = '\n' */)
     {
         std::string tmp;
         std::getline(is, tmp, delim);
-        str = utf8::string(tmp);
+        str = utf8::string(tmp, str.resource());
         return is;
     }
 }
 
 std::ostream & operator << (std::ostream & os, utf8::string const & str)
 {
-    return os.write(reinterpret_cast<char const *>(&((str.data())[0])), str.data().size());
+    return os.write(reinterpret_cast<char const *>(str.bytes()), str.size());
 }
 
 std::istream & operator >> (std::istream & is, utf8::string & str)
 {
     std::string tmp;
     is >> tmp;
-    str = utf8::string(tmp);
+    str = utf8::string(tmp, str.resource());
     return is;
 }
+
+namespace std
+{
+    std::size_t hash<utf8::string>::operator () (utf8::string const & str) const
+    {
+        return utf8::detail::hash_bytes(str.bytes(), str.size());
+    }
+}
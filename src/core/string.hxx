@@ -24,61 +24,234 @@
 
 #include "types.hxx"
 #include "iterator.hxx"
+#include "offset_index.hxx"
+#include "search.hxx"
+#include "memory_resource.hxx"
+#include "error_policy.hxx"
 
 #include <vector>
+#include <functional>
 #include <iosfwd>
+#include <iterator>
 #include <string>
 #include <cstddef>
 
 namespace utf8
 {
+    class string_view;
+
+    namespace detail
+    {
+        class case_mapper;
+    }
+
     // NOTE: utf-8 string's do not contain a NULL byte while the
     // byte stream used to initialize the string might contain one
+    //
+    // Short strings (up to SHORT_CAPACITY bytes) are stored inside the object
+    // and never touch the allocator.
+    //
+    // Longer strings allocate from a memory resource (see memory_resource.hxx),
+    // nullptr selects the default resource. Like std::pmr containers, copies use the
+    // default resource unless one is given, while moved and assigned-to strings
+    // keep their own. Concatenation allocates from the left operand's resource.
     class string
     {
     public:
+        typedef polymorphic_allocator<byte_t> allocator_type;
+        typedef std::vector<byte_t, allocator_type> storage_type;
+
         // This constructor will throw an std::invalid_argument exception
         // if the input string contains invalid bytes.
-        string(char const * str = nullptr);
+        string(char const * str = nullptr, memory_resource * resource = nullptr);
         ~string();
 
-        string(string const & src);
+        string(string const & src, memory_resource * resource = nullptr);
         string(string && src);
         string & operator = (string const & src);
+        // takes the storage if both strings use equal resources, copies it otherwise
+        string & operator = (string && src);
 
-        explicit string(std::string const & src);
+        // also throws std::invalid_argument if the input contains a NULL byte
+        explicit string(std::string const & src, memory_resource * resource = nullptr);
+        // copies the referenced bytes (validates them if the view has not been validated yet)
+        explicit string(string_view const & src, memory_resource * resource = nullptr);
+
+        // Constructors for untrusted input, which never throw std::invalid_argument (see error_policy.hxx).
+        // Like above, NULL bytes count as invalid.
+        // The checked ones are noexcept, they report allocation failures in the result as well.
+        // Valid input takes the same single validation pass as the other constructors.
+        string(char const * src, replace_invalid_t, memory_resource * resource = nullptr);
+        string(std::string const & src, replace_invalid_t, memory_resource * resource = nullptr);
+        string(string_view const & src, replace_invalid_t, memory_resource * resource = nullptr);
+        string(char const * src, skip_invalid_t, memory_resource * resource = nullptr);
+        string(std::string const & src, skip_invalid_t, memory_resource * resource = nullptr);
+        string(string_view const & src, skip_invalid_t, memory_resource * resource = nullptr);
+        string(char const * src, check_result & result, memory_resource * resource = nullptr) noexcept;
+        string(std::string const & src, check_result & result, memory_resource * resource = nullptr) noexcept;
+        string(string_view const & src, check_result & result, memory_resource * resource = nullptr) noexcept;
+
+        // the resource the string allocates from
+        memory_resource * resource() const;
+        allocator_type get_allocator() const;
 
         // get the length of the string in characters
         std::size_t length() const;
-        // access the data directly
-        std::vector<byte_t> const & data() const;
-        std::vector<byte_t> & data();
-        // shortcut for data().size()
+        // access the bytes directly (there are size() of them)
+        byte_t const * bytes() const;
+        // number of bytes
         std::size_t size() const;
 
-        // iterators
+        // number of bytes the string can hold without allocating
+        std::size_t capacity() const;
+        // makes room for (at least) the given number of bytes in total
+        void reserve(std::size_t size);
+
+        // Tracked while validating and appending, so both are O(1):
+        // true if every character is ASCII (length() equals size() then)
+        bool is_ascii() const;
+        // bytes of the widest character (0 if the string is empty, 1 for ASCII, at most 4)
+        // NOTE: after writing through the mutable data() this is only an upper bound
+        unsigned max_width() const;
+
+        // Compatibility accessor: it moves short strings to the heap, so there is no const
+        // overload (const reads must not modify the string, use bytes() and size() instead).
+        // NOTE: the caller is responsible for keeping the string valid and its length unchanged
+        storage_type & data();
+
+        // iterators (bidirectional, invalidated by any modification of the string)
         typedef detail::iterator const_iterator;
+        typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
         const_iterator begin() const;
         const_iterator end() const;
+        const_reverse_iterator rbegin() const;
+        const_reverse_iterator rend() const;
 
         // index operator
+        // strings longer than offset_index::STRIDE characters build an offset index on first use,
+        // afterwards every access costs at most STRIDE steps (ASCII strings are indexed directly)
         value_t operator [] (unsigned index) const;
 
-        // concatenation
+        // Searching (see utf8::match). UTF-8 is self-synchronizing, so the bytes are searched directly.
+        // from and the results are byte offsets. This will throw an std::invalid_argument exception
+        // if a needle is not valid UTF-8.
+        match find(value_t c, std::size_t from = 0) const;
+        match find(string_view const & needle, std::size_t from = 0) const;
+        // the last match starting at or before from
+        match rfind(value_t c, std::size_t from = match::npos) const;
+        match rfind(string_view const & needle, std::size_t from = match::npos) const;
+        // the first of the given characters
+        match find_first_of(string_view const & characters, std::size_t from = 0) const;
+        // number of non-overlapping occurrences
+        std::size_t count(value_t c) const;
+        std::size_t count(string_view const & needle) const;
+        bool contains(value_t c) const;
+        bool contains(string_view const & needle) const;
+
+        // Compares the bytes, which orders by code point (UTF-8 keeps the order).
+        // Returns a negative value, 0 or a positive value like std::string::compare().
+        int compare(string const & other) const;
+
+        // concatenation (see also utf8::concat() for many strings at once)
         string operator + (string const & other) const;
         string & operator += (string const & other);
-        
-        // append single characters (might be slow and shouldn't be used too often in perfomance critical code)
-        // this method is used in conversions from std::wstring to utf8::string
+        // appends a view, validating it if not done yet
+        // This will throw an std::invalid_argument exception if the view is not valid UTF-8.
+        string & append(string_view const & str);
+
+        // append single characters (use append() for many characters at once)
+        // This will throw an std::invalid_argument exception if c is not a valid Unicode character.
         void push_back(value_t c);
 
+        // Appends a buffer of UTF-32 or UTF-16 code units with a single allocation.
+        // The wchar_t overload uses UTF-16 for 2 byte and UTF-32 for 4 byte wchar_t.
+        // This will throw an std::invalid_argument exception if a character is not valid
+        // or a surrogate is unpaired. NULL characters are skipped.
+        string & append(char32_t const * str, std::size_t size);
+        string & append(char16_t const * str, std::size_t size);
+        string & append(wchar_t const * str, std::size_t size);
+
+    private:
+        // The storage of strings too long for the object itself
+        struct heap_storage
+        {
+            explicit heap_storage(storage_type && bytes);
+            heap_storage(storage_type && bytes, detail::offset_index const & index);
+
+            // The byte data of the string (the allocator holds the resource)
+            storage_type bytes;
+            // Byte offsets of every offset_index::STRIDE-th character
+            detail::offset_index index;
+        };
+
+    public:
+        // number of bytes stored without allocation
+        static std::size_t const SHORT_CAPACITY = sizeof(heap_storage) - sizeof(memory_resource *);
+
     private:
-        // The byte data of the string
-        std::vector<byte_t> data_;
-        // The length of the string in characters
+        // short strings remember the resource for the time they grow
+        struct short_storage
+        {
+            byte_t bytes[SHORT_CAPACITY];
+            memory_resource * resource;
+        };
+
+        bool is_short() const;
+        void set_short(std::size_t size, std::size_t length);
+        // sets the length of a heap string
+        void set_length(std::size_t length);
+        // raises max_width() to the given width
+        void widen(unsigned width);
+
+        // appends valid bytes containing the given number of characters at most width bytes wide
+        void append_bytes(byte_t const * strm, std::size_t size, std::size_t length, unsigned width);
+        // makes room for size more bytes and returns where to write them
+        byte_t * grow(std::size_t size);
+        // records the characters written to the bytes returned by grow()
+        void grown(std::size_t oldsize, std::size_t oldlength, std::size_t length, unsigned width);
+        template <typename CodeUnit>
+        string & append_units(CodeUnit const * str, std::size_t size);
+        // moves a short string to the heap
+        void spill();
+        // turns the string into an empty short string (keeping the resource)
+        void reset();
+
+        // byte offset of the given character
+        std::size_t offset(std::size_t character) const;
+
+        // copies the valid parts of the bytes, replacing the invalid ones if replacement is true
+        void assign_lossy(byte_t const * strm, std::size_t size, bool replacement);
+        check_result assign_checked(byte_t const * strm, std::size_t size) noexcept;
+
+        union
+        {
+            heap_storage heap_;
+            short_storage local_;
+        };
+        // The length of the string in characters.
+        // Short strings set the highest bit and pack the byte size
+        // (bits 8 - 15) and the length (bits 0 - 7) into it.
+        // The two bits below the highest one hold max_width() - 1.
         std::size_t length_;
+
+        // the iterator uses the offset index for long jumps
+        friend class detail::iterator;
+        // case mappings rewrite the bytes in place while the characters keep their size
+        friend class detail::case_mapper;
     };
 
+    // strings of different sizes or lengths are unequal without looking at the bytes
+    bool operator == (string const & lhs, string const & rhs);
+    bool operator != (string const & lhs, string const & rhs);
+    bool operator < (string const & lhs, string const & rhs);
+    bool operator <= (string const & lhs, string const & rhs);
+    bool operator > (string const & lhs, string const & rhs);
+    bool operator >= (string const & lhs, string const & rhs);
+
+    // appends to the temporary instead of copying it, so chains like a + b + c
+    // reuse a single buffer (with the geometric growth of the buffer)
+    string operator + (string && lhs, string const & rhs);
+
     // uses std::getline and std::string in the background
     std::istream & getline(std::istream & is, string & str, char delim = '\n');
 }
@@ -88,4 +261,20 @@ std::ostream & operator << (std::ostream & os, utf8::string const & str);
 // should act just like std::string but with UTF-8 :-)
 std::istream & operator >> (std::istream & is, utf8::string & str);
 
+namespace std
+{
+    // Hashes the bytes (see utf8::detail::hash_bytes()), equal to the hash of a view of the string.
+    // The hash is not cached: the inline buffer of short strings leaves no room for it and every
+    // mutation would have to reset it. utf8::interned carries a cached hash instead.
+    template <>
+    struct hash<utf8::string>
+    {
+        std::size_t operator () (utf8::string const & str) const;
+    };
+}
+
+// The members taking views accept C strings as well, which needs the complete view type.
+// It is included last, as string_view.hxx needs the complete string.
+#include "string_view.hxx"
+
 #endif // UTF8PP_CORE_STRING_HXX
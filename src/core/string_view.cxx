@@ -0,0 +1,517 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "string_view.hxx"
+#include "offset_index.hxx"
+#include "encoding.hxx"
+#include "validation.hxx"
+#include "hash.hxx"
+
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+
+#include <cstring>
+
+namespace utf8
+{
+    std::size_t const string_view::npos;
+
+    string_view::string_view()
+        : strm_(nullptr)
+        , size_(0)
+        , length_(0)
+        , state_(state::valid)
+    {
+    }
+
+    string_view::string_view(string const & str)
+        : strm_(str.bytes())
+        , size_(str.size())
+        , length_(str.length())
+        , state_(state::valid)
+    {
+    }
+
+    string_view::string_view(char const * str)
+        : strm_(reinterpret_cast<byte_t const *>(str))
+        , size_(str ? std::strlen(str) : 0)
+        , length_(0)
+        , state_(state::unchecked)
+    {
+    }
+
+    string_view::string_view(char const * str, std::size_t size)
+        : strm_(reinterpret_cast<byte_t const *>(str))
+        , size_(size)
+        , length_(0)
+        , state_(state::unchecked)
+    {
+    }
+
+    string_view::string_view(byte_t const * strm, std::size_t size)
+        : strm_(strm)
+        , size_(size)
+        , length_(0)
+        , state_(state::unchecked)
+    {
+    }
+
+    string_view::string_view(std::string const & str)
+        : strm_(reinterpret_cast<byte_t const *>(str.data()))
+        , size_(str.size())
+        , length_(0)
+        , state_(state::unchecked)
+    {
+    }
+
+    string_view::string_view(byte_t const * strm, std::size_t size, std::size_t length)
+        : strm_(strm)
+        , size_(size)
+        , length_(length)
+        , state_(state::valid)
+    {
+    }
+
+    bool string_view::validate() const
+    {
+        if (state_ == state::unchecked)
+        {
+            detail::validation_result result = detail::validate(strm_, size_, detail::nul_bytes::reject);
+            if (result.valid)
+            {
+                length_ = result.length;
+                state_ = state::valid;
+            }
+            else
+                state_ = state::invalid;
+        }
+        return state_ == state::valid;
+    }
+
+    bool string_view::validated() const
+    {
+        return state_ == state::valid;
+    }
+
+    void string_view::require_valid() const
+    {
+        if (!validate())
+            throw std::invalid_argument("String contains non UTF-8 bytes.");
+    }
+
+    std::size_t string_view::length() const
+    {
+        require_valid();
+        return length_;
+    }
+
+    byte_t const * string_view::bytes() const
+    {
+        return strm_;
+    }
+
+    std::size_t string_view::size() const
+    {
+        return size_;
+    }
+
+    bool string_view::empty() const
+    {
+        return !size_;
+    }
+
+    bool string_view::is_ascii() const
+    {
+        return length() == size_;
+    }
+
+    string_view::const_iterator string_view::begin() const
+    {
+        require_valid();
+        return const_iterator(nullptr, strm_, strm_ + size_, strm_, 0);
+    }
+
+    string_view::const_iterator string_view::end() const
+    {
+        require_valid();
+        return const_iterator(nullptr, strm_, strm_ + size_, strm_ + size_, length_);
+    }
+
+    string_view::const_reverse_iterator string_view::rbegin() const
+    {
+        return const_reverse_iterator(end());
+    }
+
+    string_view::const_reverse_iterator string_view::rend() const
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    value_t string_view::operator [] (unsigned index) const
+    {
+        if (index >= length())
+            throw std::range_error("Index is too big.");
+
+        if (length_ == size_)
+            return strm_[index];
+
+        std::size_t const byte = detail::offset_index::skip(strm_, 0, index);
+        return *const_iterator(nullptr, strm_, strm_ + size_, strm_ + byte, index);
+    }
+
+    match string_view::find(value_t c, std::size_t from /* = 0 */) const
+    {
+        byte_t character[4];
+        std::size_t const charlen = c ? detail::encoded_size(c) : 0;
+        if (!charlen)
+            return match();
+        detail::encode(c, character);
+        return find(string_view(character, charlen, 1), from);
+    }
+
+    match string_view::find(string_view const & needle, std::size_t from /* = 0 */) const
+    {
+        require_valid();
+        needle.require_valid();
+        return match(strm_, detail::find(strm_, size_, needle.strm_, needle.size_, from));
+    }
+
+    match string_view::rfind(value_t c, std::size_t from /* = match::npos */) const
+    {
+        byte_t character[4];
+        std::size_t const charlen = c ? detail::encoded_size(c) : 0;
+        if (!charlen)
+            return match();
+        detail::encode(c, character);
+        return rfind(string_view(character, charlen, 1), from);
+    }
+
+    match string_view::rfind(string_view const & needle, std::size_t from /* = match::npos */) const
+    {
+        require_valid();
+        needle.require_valid();
+        return match(strm_, detail::rfind(strm_, size_, needle.strm_, needle.size_, from));
+    }
+
+    match string_view::find_first_of(string_view const & characters, std::size_t from /* = 0 */) const
+    {
+        require_valid();
+        characters.require_valid();
+        return match(strm_, detail::find_first_of(strm_, size_, characters.strm_, characters.size_, from));
+    }
+
+    std::size_t string_view::count(value_t c) const
+    {
+        byte_t character[4];
+        std::size_t const charlen = c ? detail::encoded_size(c) : 0;
+        if (!charlen)
+            return 0;
+        detail::encode(c, character);
+        return count(string_view(character, charlen, 1));
+    }
+
+    std::size_t string_view::count(string_view const & needle) const
+    {
+        require_valid();
+        needle.require_valid();
+        return detail::count(strm_, size_, needle.strm_, needle.size_);
+    }
+
+    bool string_view::contains(value_t c) const
+    {
+        return find(c).found();
+    }
+
+    bool string_view::contains(string_view const & needle) const
+    {
+        return find(needle).found();
+    }
+
+    int string_view::compare(string_view const & other) const
+    {
+        std::size_t const common = std::min(size_, other.size_);
+        if (int const result = common ? std::memcmp(strm_, other.strm_, common) : 0)
+            return result;
+        return size_ < other.size_ ? -1 : size_ > other.size_ ? 1 : 0;
+    }
+
+    bool operator == (string_view const & lhs, string_view const & rhs)
+    {
+        return lhs.size() == rhs.size() && !(lhs.size() && std::memcmp(lhs.bytes(), rhs.bytes(), lhs.size()));
+    }
+
+    bool operator != (string_view const & lhs, string_view const & rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    bool operator < (string_view const & lhs, string_view const & rhs)
+    {
+        return lhs.compare(rhs) < 0;
+    }
+
+    bool operator <= (string_view const & lhs, string_view const & rhs)
+    {
+        return lhs.compare(rhs) <= 0;
+    }
+
+    bool operator > (string_view const & lhs, string_view const & rhs)
+    {
+        return lhs.compare(rhs) > 0;
+    }
+
+    bool operator >= (string_view const & lhs, string_view const & rhs)
+    {
+        return lhs.compare(rhs) >= 0;
+    }
+
+    bool operator == (string_view const & lhs, char const * rhs)
+    {
+        return lhs == string_view(rhs);
+    }
+
+    bool operator != (string_view const & lhs, char const * rhs)
+    {
+        return lhs != string_view(rhs);
+    }
+
+    bool operator < (string_view const & lhs, char const * rhs)
+    {
+        return lhs < string_view(rhs);
+    }
+
+    bool operator <= (string_view const & lhs, char const * rhs)
+    {
+        return lhs <= string_view(rhs);
+    }
+
+    bool operator > (string_view const & lhs, char const * rhs)
+    {
+        return lhs > string_view(rhs);
+    }
+
+    bool operator >= (string_view const & lhs, char const * rhs)
+    {
+        return lhs >= string_view(rhs);
+    }
+
+    bool operator == (char const * lhs, string_view const & rhs)
+    {
+        return string_view(lhs) == rhs;
+    }
+
+    bool operator != (char const * lhs, string_view const & rhs)
+    {
+        return string_view(lhs) != rhs;
+    }
+
+    bool operator < (char const * lhs, string_view const & rhs)
+    {
+        return string_view(lhs) < rhs;
+    }
+
+    bool operator <= (char const * lhs, string_view const & rhs)
+    {
+        return string_view(lhs) <= rhs;
+    }
+
+    bool operator > (char const * lhs, string_view const & rhs)
+    {
+        return string_view(lhs) > rhs;
+    }
+
+    bool operator >= (char const * lhs, string_view const & rhs)
+    {
+        return string_view(lhs) >= rhs;
+    }
+
+    bool operator == (string const & lhs, string_view const & rhs)
+    {
+        return string_view(lhs) == rhs;
+    }
+
+    bool operator != (string const & lhs, string_view const & rhs)
+    {
+        return string_view(lhs) != rhs;
+    }
+
+    bool operator < (string const & lhs, string_view const & rhs)
+    {
+        return string_view(lhs) < rhs;
+    }
+
+    bool operator <= (string const & lhs, string_view const & rhs)
+    {
+        return string_view(lhs) <= rhs;
+    }
+
+    bool operator > (string const & lhs, string_view const & rhs)
+    {
+        return string_view(lhs) > rhs;
+    }
+
+    bool operator >= (string const & lhs, string_view const & rhs)
+    {
+        return string_view(lhs) >= rhs;
+    }
+
+    bool operator == (string_view const & lhs, string const & rhs)
+    {
+        return lhs == string_view(rhs);
+    }
+
+    bool operator != (string_view const & lhs, string const & rhs)
+    {
+        return lhs != string_view(rhs);
+    }
+
+    bool operator < (string_view const & lhs, string const & rhs)
+    {
+        return lhs < string_view(rhs);
+    }
+
+    bool operator <= (string_view const & lhs, string const & rhs)
+    {
+        return lhs <= string_view(rhs);
+    }
+
+    bool operator > (string_view const & lhs, string const & rhs)
+    {
+        return lhs > string_view(rhs);
+    }
+
+    bool operator >= (string_view const & lhs, string const & rhs)
+    {
+        return lhs >= string_view(rhs);
+    }
+
+    bool operator == (string const & lhs, char const * rhs)
+    {
+        return string_view(lhs) == string_view(rhs);
+    }
+
+    bool operator != (string const & lhs, char const * rhs)
+    {
+        return string_view(lhs) != string_view(rhs);
+    }
+
+    bool operator < (string const & lhs, char const * rhs)
+    {
+        return string_view(lhs) < string_view(rhs);
+    }
+
+    bool operator <= (string const & lhs, char const * rhs)
+    {
+        return string_view(lhs) <= string_view(rhs);
+    }
+
+    bool operator > (string const & lhs, char const * rhs)
+    {
+        return string_view(lhs) > string_view(rhs);
+    }
+
+    bool operator >= (string const & lhs, char const * rhs)
+    {
+        return string_view(lhs) >= string_view(rhs);
+    }
+
+    bool operator == (char const * lhs, string const & rhs)
+    {
+        return string_view(lhs) == string_view(rhs);
+    }
+
+    bool operator != (char const * lhs, string const & rhs)
+    {
+        return string_view(lhs) != string_view(rhs);
+    }
+
+    bool operator < (char const * lhs, string const & rhs)
+    {
+        return string_view(lhs) < string_view(rhs);
+    }
+
+    bool operator <= (char const * lhs, string const & rhs)
+    {
+        return string_view(lhs) <= string_view(rhs);
+    }
+
+    bool operator > (char const * lhs, string const & rhs)
+    {
+        return string_view(lhs) > string_view(rhs);
+    }
+
+    bool operator >= (char const * lhs, string const & rhs)
+    {
+        return string_view(lhs) >= string_view(rhs);
+    }
+
+    string_view string_view::substr(std::size_t pos, std::size_t count /* = npos */) const
+    {
+        if (pos > length())
+            throw std::range_error("Position is too big.");
+
+        count = std::min(count, length_ - pos);
+        if (length_ == size_)
+            return string_view(strm_ + pos, count, count);
+
+        // a view up to the end doesn't have to walk the rest
+        std::size_t const first = detail::offset_index::skip(strm_, 0, pos);
+        std::size_t const last = pos + count == length_ ? size_ : detail::offset_index::skip(strm_, first, count);
+        return string_view(strm_ + first, last - first, count);
+    }
+
+    void string_view::remove_prefix(std::size_t count)
+    {
+        *this = substr(count);
+    }
+
+    void string_view::remove_suffix(std::size_t count)
+    {
+        if (count > length())
+            throw std::range_error("Count is too big.");
+
+        // walk backwards from the end, every byte but the continuation bytes starts a character
+        std::size_t last = size_;
+        if (length_ == size_)
+            last -= count;
+        else
+        {
+            for (std::size_t character = 0; character < count; ++character)
+            {
+                while ((strm_[--last] & 0xC0) == 0x80)
+                    ;
+            }
+        }
+        *this = string_view(strm_, last, length_ - count);
+    }
+}
+
+std::ostream & operator << (std::ostream & os, utf8::string_view const & view)
+{
+    return os.write(reinterpret_cast<char const *>(view.bytes()), view.size());
+}
+
+namespace std
+{
+    std::size_t hash<utf8::string_view>::operator () (utf8::string_view const & view) const
+    {
+        return utf8::detail::hash_bytes(view.bytes(), view.size());
+    }
+}
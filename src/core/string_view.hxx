@@ -0,0 +1,212 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef UTF8PP_CORE_STRINGVIEW_HXX
+#define UTF8PP_CORE_STRINGVIEW_HXX
+
+#include "types.hxx"
+#include "iterator.hxx"
+#include "string.hxx"
+#include "search.hxx"
+
+#include <functional>
+#include <iosfwd>
+#include <iterator>
+#include <string>
+#include <cstddef>
+
+namespace utf8
+{
+    // A non owning reference to UTF-8 bytes stored elsewhere.
+    // Views of utf8::string are valid right away, views of other byte streams
+    // are validated on first use (length(), iteration, indexing, substr).
+    // The result of the validation is cached, so do not share such a view
+    // between threads before it has been validated.
+    // NOTE: just like utf8::string a view must not contain a NULL byte
+    class string_view
+    {
+    public:
+        string_view();
+
+        // views of utf8::string are already validated
+        string_view(string const & str);
+
+        // these reference unchecked bytes
+        string_view(char const * str);
+        string_view(char const * str, std::size_t size);
+        string_view(byte_t const * strm, std::size_t size);
+        explicit string_view(std::string const & str);
+
+        // validates the bytes if not done yet, returns false if they are not valid UTF-8
+        bool validate() const;
+        // true if the bytes have been validated successfully
+        bool validated() const;
+
+        // get the length of the view in characters
+        // This will throw an std::invalid_argument exception if the bytes are not valid.
+        std::size_t length() const;
+        // access the bytes directly
+        byte_t const * bytes() const;
+        // number of bytes
+        std::size_t size() const;
+        bool empty() const;
+        // true if every character is ASCII (validates the bytes first)
+        bool is_ascii() const;
+
+        // iterators (validate the bytes first)
+        typedef detail::iterator const_iterator;
+        typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+        const_iterator begin() const;
+        const_iterator end() const;
+        const_reverse_iterator rbegin() const;
+        const_reverse_iterator rend() const;
+
+        // index operator (walks from the first character unless the view is ASCII)
+        value_t operator [] (unsigned index) const;
+
+        // Searching (see utf8::match). UTF-8 is self-synchronizing, so the bytes are searched directly.
+        // from and the results are byte offsets. This will throw an std::invalid_argument exception
+        // if a needle is not valid UTF-8.
+        match find(value_t c, std::size_t from = 0) const;
+        match find(string_view const & needle, std::size_t from = 0) const;
+        // the last match starting at or before from
+        match rfind(value_t c, std::size_t from = match::npos) const;
+        match rfind(string_view const & needle, std::size_t from = match::npos) const;
+        // the first of the given characters
+        match find_first_of(string_view const & characters, std::size_t from = 0) const;
+        // number of non-overlapping occurrences
+        std::size_t count(value_t c) const;
+        std::size_t count(string_view const & needle) const;
+        bool contains(value_t c) const;
+        bool contains(string_view const & needle) const;
+
+        // Compares the bytes (ordering by code point) without validating them.
+        // Returns a negative value, 0 or a positive value like std::string::compare().
+        int compare(string_view const & other) const;
+
+        // the view of count characters starting at character pos
+        string_view substr(std::size_t pos, std::size_t count = npos) const;
+        // drop the given number of characters from the front or the back
+        void remove_prefix(std::size_t count);
+        void remove_suffix(std::size_t count);
+
+        static std::size_t const npos = static_cast<std::size_t>(-1);
+
+    private:
+        enum class state
+        {
+            unchecked,
+            valid,
+            invalid
+        };
+
+        string_view(byte_t const * strm, std::size_t size, std::size_t length);
+
+        // validates the bytes and throws if they are invalid
+        void require_valid() const;
+
+        byte_t const * strm_;
+        std::size_t size_;
+
+        // mapped files are validated while loading them, split fields are slices of validated views,
+        // literals are validated by the compiler and lines by the line_reader
+        friend class mapped_file;
+        friend class split_range;
+        friend class literal;
+        friend class line_reader;
+
+        // the cached result of the validation
+        mutable std::size_t length_;
+        mutable state state_;
+    };
+}
+
+// used to write UTF-8 text to an output stream
+std::ostream & operator << (std::ostream & os, utf8::string_view const & view);
+
+namespace utf8
+{
+    // compares the bytes, NULL terminated strings are not validated
+    bool operator == (string_view const & lhs, string_view const & rhs);
+    bool operator != (string_view const & lhs, string_view const & rhs);
+    bool operator < (string_view const & lhs, string_view const & rhs);
+    bool operator <= (string_view const & lhs, string_view const & rhs);
+    bool operator > (string_view const & lhs, string_view const & rhs);
+    bool operator >= (string_view const & lhs, string_view const & rhs);
+
+    // C strings convert to strings as well, so views need their own overloads for them
+    bool operator == (string_view const & lhs, char const * rhs);
+    bool operator != (string_view const & lhs, char const * rhs);
+    bool operator < (string_view const & lhs, char const * rhs);
+    bool operator <= (string_view const & lhs, char const * rhs);
+    bool operator > (string_view const & lhs, char const * rhs);
+    bool operator >= (string_view const & lhs, char const * rhs);
+
+    bool operator == (char const * lhs, string_view const & rhs);
+    bool operator != (char const * lhs, string_view const & rhs);
+    bool operator < (char const * lhs, string_view const & rhs);
+    bool operator <= (char const * lhs, string_view const & rhs);
+    bool operator > (char const * lhs, string_view const & rhs);
+    bool operator >= (char const * lhs, string_view const & rhs);
+
+    // Mixed comparisons compare views of the operands. Without these overloads
+    // string == "..." would pick the string overload and construct a temporary
+    // (which allocates for long text and throws on invalid bytes).
+    bool operator == (string const & lhs, string_view const & rhs);
+    bool operator != (string const & lhs, string_view const & rhs);
+    bool operator < (string const & lhs, string_view const & rhs);
+    bool operator <= (string const & lhs, string_view const & rhs);
+    bool operator > (string const & lhs, string_view const & rhs);
+    bool operator >= (string const & lhs, string_view const & rhs);
+
+    bool operator == (string_view const & lhs, string const & rhs);
+    bool operator != (string_view const & lhs, string const & rhs);
+    bool operator < (string_view const & lhs, string const & rhs);
+    bool operator <= (string_view const & lhs, string const & rhs);
+    bool operator > (string_view const & lhs, string const & rhs);
+    bool operator >= (string_view const & lhs, string const & rhs);
+
+    bool operator == (string const & lhs, char const * rhs);
+    bool operator != (string const & lhs, char const * rhs);
+    bool operator < (string const & lhs, char const * rhs);
+    bool operator <= (string const & lhs, char const * rhs);
+    bool operator > (string const & lhs, char const * rhs);
+    bool operator >= (string const & lhs, char const * rhs);
+
+    bool operator == (char const * lhs, string const & rhs);
+    bool operator != (char const * lhs, string const & rhs);
+    bool operator < (char const * lhs, string const & rhs);
+    bool operator <= (char const * lhs, string const & rhs);
+    bool operator > (char const * lhs, string const & rhs);
+    bool operator >= (char const * lhs, string const & rhs);
+}
+
+namespace std
+{
+    // hashes the bytes, equal to the hash of an utf8::string with the same bytes
+    template <>
+    struct hash<utf8::string_view>
+    {
+        std::size_t operator () (utf8::string_view const & view) const;
+    };
+}
+
+#endif // UTF8PP_CORE_STRINGVIEW_HXX
@@ -0,0 +1,370 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "validation.hxx"
+#include "detail.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <cstring>
+#include <cstdint>
+
+#if defined(UTF8PP_AVX2) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    using utf8::detail::count_trailing_zeros;
+
+    // by default streams of 16 MiB and more use all cores
+    std::atomic<std::size_t> parallel_threshold(16 * 1024 * 1024);
+    std::atomic<unsigned> parallel_threads(0);
+
+#ifdef UTF8PP_AVX2
+    bool cpu_supports_avx2()
+    {
+#if defined(__GNUC__)
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+#elif defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+
+        // the OS has to save the AVX registers (OSXSAVE + AVX + XCR0 bits)
+        __cpuid(info, 1);
+        int const osxsave_avx = (1 << 27) | (1 << 28);
+        if ((info[2] & osxsave_avx) != osxsave_avx)
+            return false;
+        if ((_xgetbv(0) & 0x6) != 0x6)
+            return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return false;
+#endif
+    }
+#endif
+
+    utf8::detail::validation_kernel select_kernel()
+    {
+#ifdef UTF8PP_AVX2
+        if (cpu_supports_avx2())
+            return utf8::detail::validation_kernel::avx2;
+#endif
+#ifdef UTF8PP_SSE2
+        return utf8::detail::validation_kernel::sse2;
+#else
+        return utf8::detail::validation_kernel::scalar;
+#endif
+    }
+
+#ifdef UTF8PP_SSE2
+    // skips ASCII blocks 16 bytes at a time and validates
+    // the blocks containing multi byte sequences (or NULL bytes) with the scalar code
+    utf8::detail::validation_result validate_sse2(utf8::byte_t const * strm, std::size_t size, utf8::detail::nul_bytes nul)
+    {
+        bool const reject = nul == utf8::detail::nul_bytes::reject;
+        std::size_t pos = 0, length = 0;
+        unsigned width = 0;
+        while (pos + 16 <= size)
+        {
+            __m128i const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(strm + pos));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(chunk));
+            if (reject)
+                mask |= static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_setzero_si128())));
+            if (!mask)
+            {
+                pos += 16;
+                length += 16;
+                width = std::max(width, 1u);
+                continue;
+            }
+
+            // skip the leading ASCII bytes of the block
+            unsigned const ascii = count_trailing_zeros(mask);
+            pos += ascii;
+            length += ascii;
+            if (ascii)
+                width = std::max(width, 1u);
+
+            // a sequence might reach into the next block
+            std::size_t const stop = pos - ascii + 16;
+            while (pos < stop)
+            {
+                if (!(strm[pos] & 0x80) && (strm[pos] || !reject))
+                {
+                    ++pos, ++length;
+                    width = std::max(width, 1u);
+                    continue;
+                }
+
+                unsigned const charlen = strm[pos] ? utf8::detail::sequence_length(strm + pos, size - pos) : 0;
+                if (!charlen)
+                {
+                    utf8::detail::validation_result result = { false, length, pos, width };
+                    return result;
+                }
+                pos += charlen;
+                ++length;
+                width = std::max(width, charlen);
+            }
+        }
+
+        utf8::detail::validation_result result = utf8::detail::validate_scalar(strm + pos, size - pos, nul);
+        result.length += length;
+        result.offset += pos;
+        result.width = std::max(result.width, width);
+        return result;
+    }
+#endif
+}
+
+namespace utf8
+{
+    parallel_settings parallel_validation()
+    {
+        parallel_settings settings = { parallel_threshold.load(), parallel_threads.load() };
+        return settings;
+    }
+
+    void parallel_validation(parallel_settings const & settings)
+    {
+        parallel_threshold.store(settings.threshold);
+        parallel_threads.store(settings.threads);
+    }
+
+    namespace detail
+    {
+        unsigned lead_byte(byte_t lead, byte_t & lower, byte_t & upper)
+        {
+            // see table 3-7 (well-formed UTF-8 byte sequences) of the Unicode standard
+            lower = 0x80;
+            upper = 0xBF;
+            if (lead >= 0xC2 && lead <= 0xDF)
+                return 2;
+            if (lead >= 0xE0 && lead <= 0xEF)
+            {
+                if (lead == 0xE0) // overlong
+                    lower = 0xA0;
+                else if (lead == 0xED) // surrogates
+                    upper = 0x9F;
+                return 3;
+            }
+            if (lead >= 0xF0 && lead <= 0xF4)
+            {
+                if (lead == 0xF0) // overlong
+                    lower = 0x90;
+                else if (lead == 0xF4) // above U+10FFFF
+                    upper = 0x8F;
+                return 4;
+            }
+            return 0;
+        }
+
+        unsigned sequence_length(byte_t const * strm, std::size_t size)
+        {
+            byte_t lower, upper;
+            unsigned const charlen = lead_byte(strm[0], lower, upper);
+            if (!charlen)
+                return 0;
+
+            // character would need more bytes than available
+            if (charlen > size)
+                return 0;
+
+            if (strm[1] < lower || strm[1] > upper)
+                return 0;
+            for (unsigned byte = 2; byte < charlen; ++byte)
+            {
+                if ((strm[byte] & 0xC0) != 0x80)
+                    return 0;
+            }
+            return charlen;
+        }
+
+        unsigned maximal_subpart(byte_t const * strm, std::size_t size)
+        {
+            // the lead byte and the continuation bytes that could still have completed the character
+            byte_t lower, upper;
+            unsigned const charlen = lead_byte(strm[0], lower, upper);
+            unsigned subpart = 1;
+            if (charlen && size > 1 && strm[1] >= lower && strm[1] <= upper)
+            {
+                for (subpart = 2; subpart < charlen && subpart < size && (strm[subpart] & 0xC0) == 0x80; ++subpart)
+                    ;
+            }
+            return subpart;
+        }
+
+        unsigned max_width(byte_t const * strm, std::size_t size)
+        {
+            // the largest lead byte decides, blocks are scanned until a four byte sequence turns up
+            byte_t largest = 0;
+            for (std::size_t pos = 0; pos < size && largest < 0xF0; pos += 64)
+            {
+                std::size_t const end = std::min(size, pos + 64);
+                for (std::size_t n = pos; n < end; ++n)
+                    largest = std::max(largest, strm[n]);
+            }
+            if (!size)
+                return 0;
+            return largest < 0x80 ? 1 : largest < 0xE0 ? 2 : largest < 0xF0 ? 3 : 4;
+        }
+
+        validation_result validate_scalar(byte_t const * strm, std::size_t size, nul_bytes nul)
+        {
+            bool const reject = nul == nul_bytes::reject;
+            std::size_t pos = 0, length = 0;
+            unsigned width = 0;
+            while (pos < size)
+            {
+                if (!(strm[pos] & 0x80) && (strm[pos] || !reject))
+                {
+                    width = std::max(width, 1u);
+                    // skip ASCII runs 8 bytes at a time (the second term is non zero for words with a NULL byte)
+                    while (pos + 8 <= size)
+                    {
+                        std::uint64_t word;
+                        std::memcpy(&word, strm + pos, sizeof(word));
+                        std::uint64_t const stop = reject ? word | ((word - UINT64_C(0x0101010101010101)) & ~word) : word;
+                        if (stop & UINT64_C(0x8080808080808080))
+                            break;
+                        pos += 8;
+                        length += 8;
+                    }
+                    while (pos < size && !(strm[pos] & 0x80) && (strm[pos] || !reject))
+                        ++pos, ++length;
+                    continue;
+                }
+
+                unsigned const charlen = strm[pos] ? sequence_length(strm + pos, size - pos) : 0;
+                if (!charlen)
+                {
+                    validation_result result = { false, length, pos, width };
+                    return result;
+                }
+                pos += charlen;
+                ++length;
+                width = std::max(width, charlen);
+            }
+
+            validation_result result = { true, length, size, width };
+            return result;
+        }
+
+        validation_kernel best_validation_kernel()
+        {
+            // function local statics are initialized thread safe
+            static validation_kernel const kernel = select_kernel();
+            return kernel;
+        }
+
+        validation_result validate(byte_t const * strm, std::size_t size, nul_bytes nul /* = nul_bytes::accept */)
+        {
+            std::size_t const threshold = parallel_threshold.load(std::memory_order_relaxed);
+            if (threshold && size >= threshold)
+            {
+                unsigned threads = parallel_threads.load(std::memory_order_relaxed);
+                if (!threads)
+                    threads = std::thread::hardware_concurrency();
+                if (threads > 1)
+                    return validate_parallel(strm, size, threads, best_validation_kernel(), nul);
+            }
+            return validate(strm, size, best_validation_kernel(), nul);
+        }
+
+        validation_result validate_parallel(byte_t const * strm, std::size_t size, unsigned threads, validation_kernel kernel, nul_bytes nul /* = nul_bytes::accept */)
+        {
+            // chunk boundaries are moved forward to the next character start,
+            // a valid byte stream has at most 3 continuation bytes in a row
+            std::vector<std::size_t> bounds(1, 0);
+            for (unsigned chunk = 1; chunk < threads; ++chunk)
+            {
+                std::size_t bound = std::max(bounds.back(), size / threads * chunk);
+                for (unsigned step = 0; step < 3 && bound < size && (strm[bound] & 0xC0) == 0x80; ++step)
+                    ++bound;
+                bounds.push_back(bound);
+            }
+            bounds.push_back(size);
+
+            // the calling thread takes the first chunk
+            std::vector<validation_result> results(threads);
+            std::vector<std::thread> workers;
+            workers.reserve(threads - 1);
+            unsigned spawned = 1;
+            try
+            {
+                for (; spawned < threads; ++spawned)
+                {
+                    workers.emplace_back([&results, &bounds, strm, kernel, nul, spawned]() {
+                        results[spawned] = validate(strm + bounds[spawned], bounds[spawned + 1] - bounds[spawned], kernel, nul);
+                    });
+                }
+            }
+            catch (std::system_error const &)
+            {
+                // out of threads, the calling thread does the remaining work
+            }
+
+            results[0] = validate(strm, bounds[1], kernel, nul);
+            for (unsigned chunk = spawned; chunk < threads; ++chunk)
+                results[chunk] = validate(strm + bounds[chunk], bounds[chunk + 1] - bounds[chunk], kernel, nul);
+            for (std::thread & worker : workers)
+                worker.join();
+
+            // merge the results up to the first error
+            validation_result merged = { true, 0, size, 0 };
+            for (unsigned chunk = 0; chunk < threads; ++chunk)
+            {
+                merged.length += results[chunk].length;
+                merged.width = std::max(merged.width, results[chunk].width);
+                if (!results[chunk].valid)
+                {
+                    merged.valid = false;
+                    merged.offset = bounds[chunk] + results[chunk].offset;
+                    break;
+                }
+            }
+            return merged;
+        }
+
+        validation_result validate(byte_t const * strm, std::size_t size, validation_kernel kernel, nul_bytes nul /* = nul_bytes::accept */)
+        {
+            // AVX2 falls back to SSE2 if the CPU lacks it, both fall back to scalar if the build does
+#ifdef UTF8PP_AVX2
+            if (kernel == validation_kernel::avx2 && best_validation_kernel() == validation_kernel::avx2)
+                return validate_avx2(strm, size, nul);
+#endif
+#ifdef UTF8PP_SSE2
+            if (kernel != validation_kernel::scalar)
+                return validate_sse2(strm, size, nul);
+#endif
+            return validate_scalar(strm, size, nul);
+        }
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef UTF8PP_CORE_VALIDATION_HXX
+#define UTF8PP_CORE_VALIDATION_HXX
+
+#include "types.hxx"
+
+#include <cstddef>
+
+namespace utf8
+{
+    // settings for validating large byte streams on multiple threads
+    struct parallel_settings
+    {
+        // byte streams smaller than this are validated on the calling thread (0 disables the parallel mode)
+        std::size_t threshold;
+        // number of threads to use, 0 means std::thread::hardware_concurrency()
+        unsigned threads;
+    };
+
+    // get and set the settings used by all validations (thread safe)
+    parallel_settings parallel_validation();
+    void parallel_validation(parallel_settings const & settings);
+
+    namespace detail
+    {
+        // the result of validating a byte stream
+        struct validation_result
+        {
+            // true if the whole byte stream is valid UTF-8
+            bool valid;
+            // number of characters in the valid part of the byte stream
+            std::size_t length;
+            // byte offset of the first invalid sequence (equals the size if valid)
+            std::size_t offset;
+            // bytes of the longest sequence in the valid part (0 if it is empty, 1 for ASCII)
+            unsigned width;
+        };
+
+        // the available implementations of the validator
+        enum class validation_kernel
+        {
+            scalar,
+            sse2,
+            avx2
+        };
+
+        // NULL bytes are valid UTF-8, but not allowed in utf8::string and utf8::string_view
+        // (rejecting them in the validation pass saves a second pass over the bytes)
+        enum class nul_bytes
+        {
+            accept,
+            reject
+        };
+
+        // the fastest kernel supported by both the build and the executing CPU
+        validation_kernel best_validation_kernel();
+
+        // Validates a byte stream and counts its characters in a single pass.
+        // Besides malformed sequences this also rejects overlong encodings,
+        // surrogates (U+D800 - U+DFFF) and everything above U+10FFFF.
+        // Byte streams above the parallel_validation() threshold are split
+        // at character boundaries and the chunks are validated concurrently.
+        // A rejected NULL byte is reported like an invalid sequence at its offset.
+        validation_result validate(byte_t const * strm, std::size_t size, nul_bytes nul = nul_bytes::accept);
+
+        // same as above, but forces a specific kernel (used for testing)
+        // kernels not supported by the build or the CPU fall back to a slower one
+        validation_result validate(byte_t const * strm, std::size_t size, validation_kernel kernel, nul_bytes nul = nul_bytes::accept);
+
+        // validates the byte stream in (up to) the given number of chunks concurrently
+        validation_result validate_parallel(byte_t const * strm, std::size_t size, unsigned threads, validation_kernel kernel, nul_bytes nul = nul_bytes::accept);
+
+        // the length of a well-formed sequence starting with the given lead byte (0 for other bytes)
+        // and the range of its second byte
+        unsigned lead_byte(byte_t lead, byte_t & lower, byte_t & upper);
+
+        // byte length of the well-formed multi byte sequence at strm or 0 if it is malformed
+        unsigned sequence_length(byte_t const * strm, std::size_t size);
+
+        // Byte length of the maximal subpart of the ill-formed sequence at strm (at least 1).
+        // Replacing each maximal subpart with one U+FFFD is the practice recommended by the
+        // Unicode standard (section 3.9).
+        unsigned maximal_subpart(byte_t const * strm, std::size_t size);
+
+        // bytes of the longest sequence in valid UTF-8 (0 if it is empty, 1 for ASCII)
+        unsigned max_width(byte_t const * strm, std::size_t size);
+
+        // the kernels shared between the translation units
+        validation_result validate_scalar(byte_t const * strm, std::size_t size, nul_bytes nul);
+        validation_result validate_avx2(byte_t const * strm, std::size_t size, nul_bytes nul);
+    }
+}
+
+#endif // UTF8PP_CORE_VALIDATION_HXX
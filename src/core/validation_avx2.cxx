@@ -0,0 +1,320 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// This file is compiled with AVX2 enabled (see CMakeLists.txt).
+// Its code must only be called after checking the CPU supports it.
+
+#include "validation.hxx"
+#include "detail.hxx"
+
+#include <algorithm>
+
+#include <cstring>
+
+#if defined(UTF8PP_AVX2) && (defined(__AVX2__) || defined(_MSC_VER))
+#include <immintrin.h>
+
+namespace
+{
+    using utf8::detail::count_trailing_zeros;
+
+    // The validation follows the lookup algorithm by John Keiser and Daniel Lemire
+    // ("Validating UTF-8 In Less Than One Instruction Per Byte", 2020):
+    // every error can be recognized by looking at the high and low nibble of the
+    // previous byte and the high nibble of the current byte.
+    utf8::byte_t const TOO_SHORT    = 1 << 0; // 11______ 0_______ or 11______ 11______
+    utf8::byte_t const TOO_LONG     = 1 << 1; // 0_______ 10______
+    utf8::byte_t const OVERLONG_3   = 1 << 2; // 11100000 100_____
+    utf8::byte_t const TOO_LARGE    = 1 << 3; // 11110100 1001____ and above
+    utf8::byte_t const SURROGATE    = 1 << 4; // 11101101 101_____
+    utf8::byte_t const OVERLONG_2   = 1 << 5; // 1100000_ 10______
+    utf8::byte_t const TOO_LARGE_1000 = 1 << 6; // 11110101 1000____ and above
+    utf8::byte_t const OVERLONG_4   = 1 << 6; // 11110000 1000____
+    utf8::byte_t const TWO_CONTS    = 1 << 7; // 10______ 10______
+    utf8::byte_t const CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+    inline __m256i table(
+        utf8::byte_t b0, utf8::byte_t b1, utf8::byte_t b2, utf8::byte_t b3,
+        utf8::byte_t b4, utf8::byte_t b5, utf8::byte_t b6, utf8::byte_t b7,
+        utf8::byte_t b8, utf8::byte_t b9, utf8::byte_t b10, utf8::byte_t b11,
+        utf8::byte_t b12, utf8::byte_t b13, utf8::byte_t b14, utf8::byte_t b15)
+    {
+        // vpshufb works on 128 bit lanes, so both lanes get the same table
+        return _mm256_setr_epi8(
+            b0, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10, b11, b12, b13, b14, b15,
+            b0, b1, b2, b3, b4, b5, b6, b7, b8, b9, b10, b11, b12, b13, b14, b15);
+    }
+
+    inline __m256i high_nibbles(__m256i input)
+    {
+        return _mm256_and_si256(_mm256_srli_epi16(input, 4), _mm256_set1_epi8(0x0F));
+    }
+
+    // the input shifted by N bytes with the last bytes of the previous block shifted in
+    template <int N>
+    inline __m256i prev(__m256i input, __m256i prev_input)
+    {
+        return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev_input, input, 0x21), 16 - N);
+    }
+
+    inline __m256i check_special_cases(__m256i input, __m256i prev1)
+    {
+        __m256i const byte_1_high = _mm256_shuffle_epi8(table(
+            // 0_______ ________ <ASCII in byte 1>
+            TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+            TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+            // 10______ ________ <continuation in byte 1>
+            TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+            // 1100____ ________ <two byte lead in byte 1>
+            TOO_SHORT | OVERLONG_2,
+            // 1101____ ________ <two byte lead in byte 1>
+            TOO_SHORT,
+            // 1110____ ________ <three byte lead in byte 1>
+            TOO_SHORT | OVERLONG_3 | SURROGATE,
+            // 1111____ ________ <four+ byte lead in byte 1>
+            TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4
+        ), high_nibbles(prev1));
+
+        __m256i const byte_1_low = _mm256_shuffle_epi8(table(
+            // ____0000 ________
+            CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+            // ____0001 ________
+            CARRY | OVERLONG_2,
+            // ____001_ ________
+            CARRY,
+            CARRY,
+            // ____0100 ________
+            CARRY | TOO_LARGE,
+            // ____0101 ________
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            // ____011_ ________
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            // ____1___ ________
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            // ____1101 ________
+            CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000
+        ), _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)));
+
+        __m256i const byte_2_high = _mm256_shuffle_epi8(table(
+            // ________ 0_______ <ASCII in byte 2>
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+            // ________ 1000____
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+            // ________ 1001____
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+            // ________ 101_____
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            // ________ 11______
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT
+        ), high_nibbles(input));
+
+        return _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+    }
+
+    inline __m256i check_multibyte_lengths(__m256i input, __m256i prev_input, __m256i special_cases)
+    {
+        // only 111_____ (third byte) and 1111____ (fourth byte) end up with the high bit set
+        __m256i const is_third_byte = _mm256_subs_epu8(prev<2>(input, prev_input), _mm256_set1_epi8(0xE0 - 0x80));
+        __m256i const is_fourth_byte = _mm256_subs_epu8(prev<3>(input, prev_input), _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+        __m256i const must_be_continuation = _mm256_and_si256(
+            _mm256_or_si256(is_third_byte, is_fourth_byte), _mm256_set1_epi8(static_cast<char>(0x80)));
+        return _mm256_xor_si256(must_be_continuation, special_cases);
+    }
+
+    // non zero if the block ends with an unfinished multi byte sequence
+    inline __m256i is_incomplete(__m256i input)
+    {
+        __m256i const max_value = _mm256_setr_epi8(
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+        return _mm256_subs_epu8(input, max_value);
+    }
+
+    // the character count of a block is the number of non continuation bytes
+    inline __m256i leading_bytes(__m256i input)
+    {
+        // signed compare: continuation bytes are -128 .. -65
+        return _mm256_cmpgt_epi8(input, _mm256_set1_epi8(-65));
+    }
+
+    inline std::size_t horizontal_sum(__m256i counts)
+    {
+        __m256i const sums = _mm256_sad_epu8(counts, _mm256_setzero_si256());
+        return static_cast<std::size_t>(_mm256_extract_epi64(sums, 0))
+            + static_cast<std::size_t>(_mm256_extract_epi64(sums, 1))
+            + static_cast<std::size_t>(_mm256_extract_epi64(sums, 2))
+            + static_cast<std::size_t>(_mm256_extract_epi64(sums, 3));
+    }
+
+    // index of the first byte of the block flagged by the error vector
+    inline std::size_t first_error(__m256i error)
+    {
+        return count_trailing_zeros(~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(error, _mm256_setzero_si256()))));
+    }
+
+    // the longest sequence in blocks whose bytes were combined with max_epu8
+    unsigned widest(__m256i max_bytes)
+    {
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(max_bytes, _mm256_set1_epi8(static_cast<char>(0xF0))), max_bytes)))
+            return 4;
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(max_bytes, _mm256_set1_epi8(static_cast<char>(0xE0))), max_bytes)))
+            return 3;
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(max_bytes, _mm256_set1_epi8(static_cast<char>(0xC0))), max_bytes)))
+            return 2;
+        return 1;
+    }
+
+    // Finds the exact position of an error detected in the block at pos. Errors are flagged
+    // at most 3 bytes behind the start of the faulty sequence, so the scalar validation
+    // only has to start a few bytes before the flagged byte (for a length error flagged
+    // at the start of a block: in the previous block). length counts the characters before pos.
+    // max_bytes combines the bytes of the blocks before the previous one.
+    utf8::detail::validation_result locate_error(utf8::byte_t const * strm, std::size_t size, std::size_t pos, std::size_t length, std::size_t flagged, __m256i max_bytes, utf8::detail::nul_bytes nul)
+    {
+        flagged = std::min(flagged, size);
+        std::size_t start = flagged < 3 ? 0 : flagged - 3;
+        while (start < flagged && (strm[start] & 0xC0) == 0x80)
+            ++start;
+        for (std::size_t n = pos; n < start; ++n)
+        {
+            if ((strm[n] & 0xC0) != 0x80)
+                ++length;
+        }
+        for (std::size_t n = start; n < pos; ++n)
+        {
+            if ((strm[n] & 0xC0) != 0x80)
+                --length;
+        }
+
+        // max_bytes covers the blocks before the previous one, the error might have been found one block late
+        std::size_t const confirmed = pos < 32 ? 0 : pos - 32;
+        unsigned width = confirmed ? widest(max_bytes) : 0;
+        for (std::size_t n = confirmed; n < start; ++n)
+        {
+            if ((strm[n] & 0xC0) != 0x80)
+                width = std::max(width, strm[n] < 0x80 ? 1u : strm[n] < 0xE0 ? 2u : strm[n] < 0xF0 ? 3u : 4u);
+        }
+
+        utf8::detail::validation_result result = utf8::detail::validate_scalar(strm + start, size - start, nul);
+        result.length += length;
+        result.offset += start;
+        result.width = std::max(result.width, width);
+        return result;
+    }
+}
+
+namespace utf8
+{
+    namespace detail
+    {
+        validation_result validate_avx2(byte_t const * strm, std::size_t size, nul_bytes nul)
+        {
+            bool const reject = nul == nul_bytes::reject;
+            __m256i prev_input = _mm256_setzero_si256();
+            __m256i prev_incomplete = _mm256_setzero_si256();
+            // the largest bytes of the blocks tell the widest sequence
+            __m256i max_bytes = _mm256_setzero_si256();
+            std::size_t pos = 0, length = 0;
+
+            while (pos + 32 <= size)
+            {
+                // the per byte counters overflow after 255 blocks
+                __m256i counts = _mm256_setzero_si256();
+                for (unsigned block = 0; block < 255 && pos + 32 <= size; ++block, pos += 32)
+                {
+                    __m256i const input = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(strm + pos));
+                    __m256i const nuls = reject ? _mm256_cmpeq_epi8(input, _mm256_setzero_si256()) : _mm256_setzero_si256();
+                    if (!_mm256_movemask_epi8(input))
+                    {
+                        // ASCII only, unless the previous block was unfinished
+                        if (!_mm256_testz_si256(prev_incomplete, prev_incomplete))
+                            return locate_error(strm, size, pos, length + horizontal_sum(counts), pos, max_bytes, nul);
+                        if (!_mm256_testz_si256(nuls, nuls))
+                            return locate_error(strm, size, pos, length + horizontal_sum(counts), pos + first_error(nuls), max_bytes, nul);
+                    }
+                    else
+                    {
+                        __m256i const error = _mm256_or_si256(nuls,
+                            check_multibyte_lengths(input, prev_input, check_special_cases(input, prev<1>(input, prev_input))));
+                        if (!_mm256_testz_si256(error, error))
+                            return locate_error(strm, size, pos, length + horizontal_sum(counts), pos + first_error(error), max_bytes, nul);
+                    }
+                    // no error so far, so the previous block was valid
+                    max_bytes = _mm256_max_epu8(max_bytes, prev_input);
+                    prev_incomplete = is_incomplete(input);
+
+                    counts = _mm256_sub_epi8(counts, leading_bytes(input));
+                    prev_input = input;
+                }
+                length += horizontal_sum(counts);
+            }
+
+            // the remaining bytes are padded with NUL bytes which also catches unfinished sequences
+            byte_t buffer[32] = { 0 };
+            std::size_t const remaining = size - pos;
+            if (remaining)
+                std::memcpy(buffer, strm + pos, remaining);
+
+            __m256i const input = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(buffer));
+            __m256i error = check_multibyte_lengths(input, prev_input, check_special_cases(input, prev<1>(input, prev_input)));
+            if (reject)
+            {
+                // only the NULL bytes in front of the padding count
+                __m256i const index = _mm256_setr_epi8(
+                    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                    16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);
+                __m256i const inside = _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(remaining)), index);
+                error = _mm256_or_si256(error, _mm256_and_si256(inside, _mm256_cmpeq_epi8(input, _mm256_setzero_si256())));
+            }
+            if (!_mm256_testz_si256(error, error))
+                return locate_error(strm, size, pos, length, pos + first_error(error), max_bytes, nul);
+
+            length += horizontal_sum(_mm256_sub_epi8(_mm256_setzero_si256(), leading_bytes(input))) - (32 - remaining);
+
+            validation_result result = { true, length, size, size ? widest(_mm256_max_epu8(_mm256_max_epu8(max_bytes, prev_input), input)) : 0 };
+            return result;
+        }
+    }
+}
+
+#else
+
+namespace utf8
+{
+    namespace detail
+    {
+        validation_result validate_avx2(byte_t const * strm, std::size_t size, nul_bytes nul)
+        {
+            // built without AVX2 support
+            return validate_scalar(strm, size, nul);
+        }
+    }
+}
+
+#endif
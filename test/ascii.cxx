@@ -0,0 +1,110 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#define UTF8PP_TEST
+
+#include "tests.hxx"
+
+#include "core/string.hxx"
+#include "core/string_view.hxx"
+#include "conversion/encoding_cast.hxx"
+
+#include <string>
+#include <utility>
+
+unsigned test_ascii()
+{
+    unsigned failures = 0;
+
+    utf8::string empty;
+    UTF8PP_CHECK(failures, empty.is_ascii() && empty.max_width() == 0);
+
+    // the width is known after validating
+    UTF8PP_CHECK(failures, utf8::string("plain").is_ascii() && utf8::string("plain").max_width() == 1);
+    UTF8PP_CHECK(failures, utf8::string(u8"café").max_width() == 2 && !utf8::string(u8"café").is_ascii());
+    UTF8PP_CHECK(failures, utf8::string(std::string(u8"5 €")).max_width() == 3);
+    UTF8PP_CHECK(failures, utf8::string(utf8::string_view(u8"\U0001F600!")).max_width() == 4);
+
+    // and kept up to date by appending, also when short strings move to the heap
+    utf8::string grown("short");
+    grown += utf8::string(std::string(100, 'x'));
+    UTF8PP_CHECK(failures, grown.is_ascii() && grown.max_width() == 1 && grown.length() == 105);
+    grown.push_back(0xE9);
+    UTF8PP_CHECK(failures, !grown.is_ascii() && grown.max_width() == 2);
+    grown += utf8::string(u8"€");
+    UTF8PP_CHECK(failures, grown.max_width() == 3);
+    grown.push_back('a');
+    UTF8PP_CHECK(failures, grown.max_width() == 3);
+    char32_t const emoji[] = { 0x1F600 };
+    grown.append(emoji, 1);
+    UTF8PP_CHECK(failures, grown.max_width() == 4 && grown.length() == 109);
+
+    utf8::string units;
+    units.append(u"abc", 3);
+    UTF8PP_CHECK(failures, units.is_ascii() && units.max_width() == 1);
+    units.append(u"ü", 1);
+    UTF8PP_CHECK(failures, units.max_width() == 2);
+
+    // copies and moves keep it, replacement characters are three bytes wide
+    utf8::string const copy(grown);
+    UTF8PP_CHECK(failures, copy.max_width() == 4 && copy.length() == grown.length());
+    utf8::string moved(std::move(units));
+    UTF8PP_CHECK(failures, moved.max_width() == 2 && moved.length() == 4);
+    UTF8PP_CHECK(failures, utf8::string("ab\xFF", utf8::replace_invalid).max_width() == 3);
+    UTF8PP_CHECK(failures, utf8::string("ab\xFF", utf8::skip_invalid).is_ascii());
+    utf8::check_result result;
+    UTF8PP_CHECK(failures, utf8::string(u8"é", result).max_width() == 2 && result);
+
+    // ASCII strings are indexed and iterated without decoding
+    std::string bytes;
+    for (unsigned n = 0; n < 1000; ++n)
+        bytes.push_back(static_cast<char>('!' + n % 90));
+    utf8::string const ascii(bytes);
+    bool same = true;
+    for (unsigned n = 0; n < bytes.size(); n += 7)
+        same = same && ascii[n] == static_cast<utf8::value_t>(bytes[n]);
+    UTF8PP_CHECK(failures, same);
+    utf8::string::const_iterator it = ascii.begin();
+    it += 3;
+    UTF8PP_CHECK(failures, *it == static_cast<utf8::value_t>(bytes[3]) && it.position() == 3);
+    it += 500;
+    UTF8PP_CHECK(failures, *it == static_cast<utf8::value_t>(bytes[503]) && it.offset() == 503);
+    it += 1000;
+    UTF8PP_CHECK(failures, it == ascii.end());
+
+    utf8::string_view const view(bytes);
+    UTF8PP_CHECK(failures, view.is_ascii() && view[999] == static_cast<utf8::value_t>(bytes[999]));
+    UTF8PP_CHECK(failures, view.substr(10, 5).size() == 5 && view.substr(10, 5)[0] == static_cast<utf8::value_t>(bytes[10]));
+    UTF8PP_CHECK(failures, !utf8::string_view(u8"été").is_ascii());
+
+    // the converters widen ASCII directly
+    UTF8PP_CHECK(failures, utf8::encoding_cast<std::u32string>(ascii) == std::u32string(bytes.begin(), bytes.end()));
+    UTF8PP_CHECK(failures, utf8::encoding_cast<std::u16string>(ascii) == std::u16string(bytes.begin(), bytes.end()));
+    UTF8PP_CHECK(failures, utf8::encoding_cast<std::wstring>(ascii) == std::wstring(bytes.begin(), bytes.end()));
+    UTF8PP_CHECK(failures, utf8::encoding_cast<std::u16string>(utf8::string(u8"5 €")) == u"5 €");
+    UTF8PP_CHECK(failures, utf8::encoding_cast<std::u16string>(utf8::string(u8"\U0001F600")).size() == 2);
+
+    // writing through data() leaves an upper bound
+    utf8::string written(bytes);
+    written.data()[0] = 'A';
+    UTF8PP_CHECK(failures, written.is_ascii() && written.max_width() == 4 && written[0] == 'A');
+
+    return failures;
+}
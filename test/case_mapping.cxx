@@ -0,0 +1,104 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tests.hxx"
+
+#include "core/case_mapping.hxx"
+#include "core/memory_resource.hxx"
+
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    std::string bytes(utf8::string const & str)
+    {
+        return std::string(reinterpret_cast<char const *>(str.bytes()), str.size());
+    }
+}
+
+unsigned test_case_mapping()
+{
+    unsigned failures = 0;
+
+    UTF8PP_CHECK(failures, bytes(utf8::to_lower("Hello, World!")) == "hello, world!");
+    UTF8PP_CHECK(failures, bytes(utf8::to_upper("Hello, World!")) == "HELLO, WORLD!");
+    UTF8PP_CHECK(failures, bytes(utf8::to_lower(u8"ÀÉÎÕÜ")) == u8"àéîõü");
+    UTF8PP_CHECK(failures, bytes(utf8::to_upper(u8"αβγ абв")) == u8"ΑΒΓ АБВ");
+    // mappings to several characters and to characters of other sizes
+    UTF8PP_CHECK(failures, bytes(utf8::to_upper(u8"straße")) == "STRASSE");
+    UTF8PP_CHECK(failures, bytes(utf8::casefold(u8"Straße")) == "strasse");
+    UTF8PP_CHECK(failures, bytes(utf8::to_lower(u8"\u0130")) == u8"i\u0307");
+    UTF8PP_CHECK(failures, bytes(utf8::to_lower(u8"\u212A")) == "k");
+    UTF8PP_CHECK(failures, bytes(utf8::to_upper(u8"\U00010428")) == u8"\U00010400");
+    // no conditional mappings
+    UTF8PP_CHECK(failures, bytes(utf8::to_lower(u8"ΣΑΣ")) == u8"σασ");
+
+    // ASCII blocks with other characters in between
+    std::string mixed, lower, upper;
+    for (unsigned n = 0; n < 100; ++n)
+    {
+        mixed += n % 7 ? "AbCdEfGhIjKlMnOpQrStUvWxYz@[`{" : u8"Äß";
+        lower += n % 7 ? "abcdefghijklmnopqrstuvwxyz@[`{" : u8"äß";
+        upper += n % 7 ? "ABCDEFGHIJKLMNOPQRSTUVWXYZ@[`{" : u8"ÄSS";
+    }
+    utf8::string_view const mixed_view(mixed);
+    UTF8PP_CHECK(failures, bytes(utf8::to_lower(mixed_view)) == lower);
+    UTF8PP_CHECK(failures, bytes(utf8::to_upper(mixed_view)) == upper);
+    UTF8PP_CHECK(failures, utf8::to_upper(mixed_view).length() == utf8::string_view(upper).length());
+
+    // strings keeping their size are rewritten in place
+    utf8::string str(mixed);
+    utf8::byte_t const * const storage = str.bytes();
+    utf8::string const lowered = utf8::to_lower(std::move(str));
+    UTF8PP_CHECK(failures, lowered.bytes() == storage);
+    UTF8PP_CHECK(failures, bytes(lowered) == lower);
+    utf8::string const uppered = utf8::to_upper(utf8::string(mixed));
+    UTF8PP_CHECK(failures, bytes(uppered) == upper);
+    UTF8PP_CHECK(failures, uppered.length() == utf8::string_view(upper).length());
+    UTF8PP_CHECK(failures, bytes(utf8::casefold(utf8::string(u8"\u212A\u212B"))) == u8"k\u00E5");
+
+    // the result allocates from the given resource
+    utf8::arena_resource arena;
+    UTF8PP_CHECK(failures, utf8::casefold(mixed_view, &arena).resource() == &arena);
+
+    // caseless comparison
+    UTF8PP_CHECK(failures, utf8::iequals("HeLLo", "hello"));
+    UTF8PP_CHECK(failures, utf8::iequals(u8"Straße", "STRASSE"));
+    UTF8PP_CHECK(failures, utf8::iequals(u8"\uFB01le", "FILE"));
+    UTF8PP_CHECK(failures, utf8::iequals(mixed_view, utf8::string_view(upper)));
+    UTF8PP_CHECK(failures, !utf8::iequals("abc", "abd"));
+    UTF8PP_CHECK(failures, !utf8::iequals("abc", "abcd"));
+    UTF8PP_CHECK(failures, utf8::icompare("abc", "ABD") < 0);
+    UTF8PP_CHECK(failures, utf8::icompare("ABD", "abc") > 0);
+    UTF8PP_CHECK(failures, utf8::icompare("ABC", "abcd") < 0);
+    UTF8PP_CHECK(failures, utf8::icompare("", "") == 0);
+    // folded letters are lower case, so '[' (after 'Z') orders before 'a'
+    UTF8PP_CHECK(failures, utf8::icompare("[", "A") < 0);
+    std::string changed = upper;
+    changed[40] = '?';
+    UTF8PP_CHECK(failures, utf8::icompare(mixed_view, utf8::string_view(changed)) > 0);
+
+    bool thrown = false;
+    try { utf8::iequals("a", "\xC3"); }
+    catch (std::invalid_argument const &) { thrown = true; }
+    UTF8PP_CHECK(failures, thrown);
+
+    return failures;
+}
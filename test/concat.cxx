@@ -0,0 +1,113 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "tests.hxx"
+
+#include "core/concat.hxx"
+#include "core/string.hxx"
+#include "core/string_view.hxx"
+#include "core/memory_resource.hxx"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+unsigned test_concat()
+{
+    unsigned failures = 0;
+    counting_resource counting;
+
+    // reserve moves short strings to the heap once
+    utf8::string reserved(u8"grüß", &counting);
+    UTF8PP_CHECK(failures, reserved.capacity() == utf8::string::SHORT_CAPACITY);
+    reserved.reserve(1000);
+    UTF8PP_CHECK(failures, reserved.capacity() >= 1000 && counting.allocations == 1);
+    for (unsigned n = 0; n < 300; ++n)
+        reserved.push_back(0x20AC);
+    UTF8PP_CHECK(failures, counting.allocations == 1 && reserved.length() == 304 && reserved[303] == 0x20AC);
+    reserved.reserve(10);
+    UTF8PP_CHECK(failures, reserved.capacity() >= 1000);
+
+    // appending nothing doesn't touch the buffer
+    utf8::string empty(nullptr, &counting);
+    std::size_t const allocated = counting.allocations;
+    empty.reserve(100);
+    empty += utf8::string();
+    empty.append(utf8::string_view());
+    UTF8PP_CHECK(failures, empty.size() == 0 && empty.capacity() >= 100 && counting.allocations == allocated + 1);
+
+    // chains of temporaries reuse the buffer of the first one
+    utf8::string const part(u8"a part long enough for the heap ... ä", &counting);
+    counting.allocations = 0;
+    utf8::string const chained = part + part + part + part + part;
+    UTF8PP_CHECK(failures, chained.length() == 5 * part.length() && counting.allocations <= 3);
+
+    // concat_into sizes everything first
+    counting.allocations = 0;
+    std::string const std_part("std::string ");
+    utf8::string all(nullptr, &counting);
+    utf8::concat_into(all, part, utf8::string_view(" | "), "literal ", std_part, part);
+    UTF8PP_CHECK(failures, counting.allocations == 1);
+    UTF8PP_CHECK(failures, all.length() == 2 * part.length() + 3 + 8 + 12);
+    UTF8PP_CHECK(failures, all.max_width() == 2 && all.resource() == &counting);
+    UTF8PP_CHECK(failures, equals(utf8::concat(), "") && equals(utf8::concat("a", u8"€"), u8"a€"));
+    UTF8PP_CHECK(failures, utf8::concat("a", u8"€").max_width() == 3);
+
+    bool thrown = false;
+    try { utf8::concat(part, "\xFF"); }
+    catch (std::invalid_argument const &) { thrown = true; }
+    UTF8PP_CHECK(failures, thrown);
+
+    // appending views, also of the string itself
+    utf8::string self(u8"€uro");
+    self.append(utf8::string_view(self));
+    self.append(utf8::string_view(self).substr(1, 3));
+    UTF8PP_CHECK(failures, equals(self, u8"€uro€urouro"));
+
+    // concat_into with views of the result must not read from the old buffer after reserving
+    utf8::string heap("0123456789012345678901234567890123456789-heap");
+    std::string const before(reinterpret_cast<char const *>(heap.bytes()), heap.size());
+    utf8::concat_into(heap, utf8::string_view(heap), "x", utf8::string_view(heap).substr(40));
+    UTF8PP_CHECK(failures, equals(heap, before + before + "x" + "-heap"));
+
+    utf8::string short_self(u8"äb");
+    utf8::concat_into(short_self, utf8::string_view(short_self), std::string(100, 'y'), short_self);
+    UTF8PP_CHECK(failures, equals(short_self, u8"äbäb" + std::string(100, 'y') + u8"äb"));
+
+    // move assignment takes the buffer if the resources are equal and copies it otherwise
+    utf8::string target(nullptr, &counting);
+    utf8::string source(part, &counting);
+    counting.allocations = 0;
+    utf8::byte_t const * const buffer = source.bytes();
+    target = std::move(source);
+    UTF8PP_CHECK(failures, target.bytes() == buffer && counting.allocations == 0 && source.length() == 0);
+
+    utf8::string other(part);
+    target = std::move(other);
+    UTF8PP_CHECK(failures, target.resource() == &counting && counting.allocations == 1);
+    UTF8PP_CHECK(failures, target.length() == part.length() && std::memcmp(target.bytes(), part.bytes(), part.size()) == 0);
+
+    target = utf8::string(u8"short €");
+    UTF8PP_CHECK(failures, target.resource() == &counting && equals(target, u8"short €") && target.max_width() == 3);
+
+    return failures;
+}
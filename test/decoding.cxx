@@ -0,0 +1,104 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define UTF8PP_TEST
+
+#include "tests.hxx"
+
+#include "core/string.hxx"
+#include "core/decoding.hxx"
+#include "conversion/encoding_cast.hxx"
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // ASCII runs of every length around the block size with multi byte characters in between
+    utf8::string random_text(std::mt19937 & rng, std::size_t characters)
+    {
+        utf8::value_t const wide[] = { 0xE4, 0x7FF, 0x20AC, 0xFFFD, 0x10000, 0x1F600 };
+        utf8::string text;
+        while (text.length() < characters)
+        {
+            for (std::size_t run = rng() % 40; run; --run)
+                text.push_back(0x20 + rng() % 0x5F);
+            text.push_back(wide[rng() % 6]);
+        }
+        return text;
+    }
+
+    std::u16string to_utf16(std::vector<utf8::value_t> const & characters)
+    {
+        std::u16string result;
+        for (utf8::value_t c : characters)
+        {
+            if (c > 0xFFFF)
+            {
+                result.push_back(static_cast<char16_t>(0xD800 | ((c - 0x10000) >> 10)));
+                result.push_back(static_cast<char16_t>(0xDC00 | (c & 0x3FF)));
+            }
+            else
+                result.push_back(static_cast<char16_t>(c));
+        }
+        return result;
+    }
+}
+
+unsigned test_decoding()
+{
+    unsigned failures = 0;
+
+    // the block decoder matches the iterator
+    std::mt19937 rng(7);
+    for (std::size_t characters = 0; characters < 600; characters += 1 + rng() % 30)
+    {
+        utf8::string const text = random_text(rng, characters);
+        std::vector<utf8::value_t> expected;
+        for (utf8::value_t c : text)
+            expected.push_back(c);
+
+        UTF8PP_CHECK(failures, utf8::utf32_length(text.bytes(), text.size()) == text.length());
+        std::u32string utf32(text.length(), U'\0');
+        UTF8PP_CHECK(failures, utf8::decode(text.bytes(), text.size(), &utf32[0]) == text.length());
+        UTF8PP_CHECK(failures, std::vector<utf8::value_t>(utf32.begin(), utf32.end()) == expected);
+
+        std::u16string const pairs = to_utf16(expected);
+        UTF8PP_CHECK(failures, utf8::utf16_length(text.bytes(), text.size()) == pairs.size());
+        std::u16string utf16(pairs.size(), u'\0');
+        UTF8PP_CHECK(failures, utf8::decode(text.bytes(), text.size(), &utf16[0]) == pairs.size());
+        UTF8PP_CHECK(failures, utf16 == pairs);
+    }
+
+    // long ASCII runs take the block path
+    utf8::string const ascii(std::string(1000, 'x') + u8"é" + std::string(33, 'y'));
+    std::u32string decoded(ascii.length(), U'\0');
+    utf8::decode(ascii.bytes(), ascii.size(), &decoded[0]);
+    UTF8PP_CHECK(failures, decoded == std::u32string(1000, U'x') + U"é" + std::u32string(33, U'y'));
+
+    // wide strings round trip
+    std::wstring const wide(L"€ = euro, ü = ue, \U0001F600, plain ASCII text to fill a block");
+    utf8::string const text = utf8::encoding_cast<utf8::string>(wide);
+    UTF8PP_CHECK(failures, utf8::wide_length(text.bytes(), text.size()) == wide.size());
+    UTF8PP_CHECK(failures, utf8::encoding_cast<std::wstring>(text) == wide);
+    UTF8PP_CHECK(failures, utf8::encoding_cast<std::wstring>(utf8::string()).empty());
+
+    return failures;
+}
@@ -0,0 +1,160 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define UTF8PP_TEST
+
+#include "tests.hxx"
+
+#include "core/string.hxx"
+#include "core/encoding.hxx"
+#include "conversion/encoding_cast.hxx"
+
+#include <cstring>
+#include <random>
+#include <string>
+
+namespace
+{
+    bool same(utf8::string const & a, utf8::string const & b)
+    {
+        return a.length() == b.length() && a.size() == b.size() && !std::memcmp(a.bytes(), b.bytes(), a.size());
+    }
+
+    // runs of ASCII and two byte characters with some wider ones in between
+    std::u32string random_text(std::mt19937 & rng, std::size_t characters)
+    {
+        std::u32string text;
+        while (text.size() < characters)
+        {
+            std::size_t const run = 1 + rng() % 40;
+            switch (rng() % 4)
+            {
+            case 0: for (std::size_t n = 0; n < run; ++n) text.push_back(0x20 + rng() % 0x5F); break;
+            case 1: for (std::size_t n = 0; n < run; ++n) text.push_back(0x80 + rng() % 0x780); break;
+            case 2: text.push_back(0xE000 + rng() % 0x2000); break;
+            default: text.push_back(0x10000 + rng() % 0x100000); break;
+            }
+        }
+        return text;
+    }
+
+    std::u16string to_utf16(std::u32string const & text)
+    {
+        std::u16string result;
+        for (char32_t c : text)
+        {
+            if (c > 0xFFFF)
+            {
+                result.push_back(static_cast<char16_t>(0xD800 | ((c - 0x10000) >> 10)));
+                result.push_back(static_cast<char16_t>(0xDC00 | (c & 0x3FF)));
+            }
+            else
+                result.push_back(static_cast<char16_t>(c));
+        }
+        return result;
+    }
+}
+
+unsigned test_encoding()
+{
+    unsigned failures = 0;
+
+    // the limits of every sequence length
+    char32_t const limits[] = { 0x7F, 0x80, 0x7FF, 0x800, 0xD7FF, 0xE000, 0xFFFF, 0x10000, 0x10FFFF };
+    utf8::string bulk, single;
+    bulk.append(limits, sizeof(limits) / sizeof(limits[0]));
+    for (char32_t c : limits)
+        single.push_back(c);
+    UTF8PP_CHECK(failures, same(bulk, single));
+    UTF8PP_CHECK(failures, same(bulk, utf8::string(u8"\u007F\u0080߿ࠀ퟿￿\U00010000\U0010FFFF")));
+
+    // bulk appends match appending character by character
+    std::mt19937 rng(11);
+    for (std::size_t characters = 0; characters < 500; characters += 1 + rng() % 50)
+    {
+        std::u32string const text = random_text(rng, characters);
+        utf8::string expected(u8"prefix ");
+        for (char32_t c : text)
+            expected.push_back(c);
+
+        utf8::string actual(u8"prefix ");
+        actual.append(text.data(), text.size());
+        UTF8PP_CHECK(failures, same(actual, expected));
+        for (std::size_t index = 0; index < text.size(); index += 7)
+            UTF8PP_CHECK(failures, actual[static_cast<unsigned>(index + 7)] == text[index]);
+    }
+
+    // NULL characters are skipped
+    char32_t const with_nul[] = { 'a', 0, 'b' };
+    utf8::string skipped;
+    skipped.append(with_nul, 3);
+    UTF8PP_CHECK(failures, same(skipped, utf8::string("ab")));
+    std::u16string const units_with_nul = std::u16string(12, u'a') + u'\0' + std::u16string(12, u'\xE9');
+    skipped.append(units_with_nul.data(), units_with_nul.size());
+    UTF8PP_CHECK(failures, skipped.length() == 26 && skipped.size() == 38);
+
+    // surrogates and too large values are rejected without changing the string
+    char32_t const surrogate[] = { 'a', 0xD800 }, too_large[] = { 0x110000 };
+    utf8::string unchanged("x");
+    UTF8PP_CHECK(failures, throws_invalid_argument([&]() { unchanged.append(surrogate, 2); }));
+    UTF8PP_CHECK(failures, throws_invalid_argument([&]() { unchanged.append(too_large, 1); }));
+    UTF8PP_CHECK(failures, throws_invalid_argument([&]() { unchanged.push_back(0xDFFF); }));
+    UTF8PP_CHECK(failures, same(unchanged, utf8::string("x")));
+
+    // UTF-16 with surrogate pairs at every position of the blocks
+    for (std::size_t characters = 0; characters < 300; characters += 1 + rng() % 20)
+    {
+        std::u32string const text = random_text(rng, characters);
+        std::u16string const units = to_utf16(text);
+        utf8::string expected;
+        for (char32_t c : text)
+            expected.push_back(c);
+
+        utf8::string actual;
+        actual.append(units.data(), units.size());
+        UTF8PP_CHECK(failures, same(actual, expected));
+        UTF8PP_CHECK(failures, utf8::utf8_size(units.data(), units.size()) == expected.size());
+        UTF8PP_CHECK(failures, utf8::encoding_cast<std::u16string>(actual) == units);
+        UTF8PP_CHECK(failures, utf8::encoding_cast<std::u32string>(actual) == text);
+    }
+
+    // unpaired surrogates are rejected wherever they are
+    for (std::size_t position = 0; position < 20; ++position)
+    {
+        std::u16string units(20, u'a');
+        units[position] = 0xD83D;
+        UTF8PP_CHECK(failures, throws_invalid_argument([&]() { utf8::utf8_size(units.data(), units.size()); }));
+        units[position] = 0xDE00;
+        UTF8PP_CHECK(failures, throws_invalid_argument([&]() { utf8::utf8_size(units.data(), units.size()); }));
+        if (position)
+        {
+            units[position - 1] = 0xD83D;
+            UTF8PP_CHECK(failures, utf8::utf8_size(units.data(), units.size()) == 18 + 4);
+        }
+    }
+    UTF8PP_CHECK(failures, throws_invalid_argument([]() { utf8::encoding_cast<utf8::string>(std::u16string(u"a\xDC00")); }));
+    UTF8PP_CHECK(failures, throws_invalid_argument([]() { utf8::encoding_cast<utf8::string>(std::u32string(U"a\x110000")); }));
+
+    // the wide string conversion uses the bulk encoder
+    std::wstring const wide(L"€ = euro, ü = ue, \U0001F600");
+    utf8::string const converted = utf8::encoding_cast<utf8::string>(wide);
+    UTF8PP_CHECK(failures, same(converted, utf8::string(u8"€ = euro, ü = ue, \U0001F600")));
+
+    return failures;
+}
@@ -0,0 +1,134 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tests.hxx"
+
+#include "core/string.hxx"
+#include "core/string_view.hxx"
+#include "core/validation.hxx"
+#include "core/memory_resource.hxx"
+
+#include <algorithm>
+#include <new>
+#include <random>
+#include <string>
+
+namespace
+{
+    // replaces or drops byte by byte with the scalar sequence check, stores the first error in error
+    std::string reference(std::string const & bytes, bool replacement, std::size_t & error)
+    {
+        std::string out;
+        error = bytes.size();
+        for (std::size_t pos = 0; pos < bytes.size();)
+        {
+            utf8::byte_t const * const strm = reinterpret_cast<utf8::byte_t const *>(bytes.data()) + pos;
+            unsigned const charlen = !strm[0] ? 0 : strm[0] < 0x80 ? 1 : utf8::detail::sequence_length(strm, bytes.size() - pos);
+            if (charlen)
+            {
+                out.append(bytes, pos, charlen);
+                pos += charlen;
+                continue;
+            }
+            error = std::min(error, pos);
+            pos += strm[0] ? utf8::detail::maximal_subpart(strm, bytes.size() - pos) : 1;
+            if (replacement)
+                out += "\xEF\xBF\xBD";
+        }
+        return out;
+    }
+
+    // fails every allocation
+    class throwing_resource : public utf8::memory_resource
+    {
+    private:
+        void * do_allocate(std::size_t, std::size_t) override
+        {
+            throw std::bad_alloc();
+        }
+
+        void do_deallocate(void *, std::size_t, std::size_t) override
+        {
+        }
+
+        bool do_is_equal(utf8::memory_resource const & other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+}
+
+unsigned test_error_policy()
+{
+    unsigned failures = 0;
+
+    // the example of table 3-8 in the Unicode standard
+    std::string const example("\x61\xF1\x80\x80\xE1\x80\xC2\x62\x80\x63\x80\xBF\x64");
+    UTF8PP_CHECK(failures, equals(utf8::string(example, utf8::replace_invalid),
+        "a\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD" "b\xEF\xBF\xBD" "c\xEF\xBF\xBD\xEF\xBF\xBD" "d"));
+    UTF8PP_CHECK(failures, equals(utf8::string(example, utf8::skip_invalid), "abcd"));
+
+    // the checked mode reports the first error and copies nothing
+    utf8::check_result result;
+    utf8::string const rejected(example, result);
+    UTF8PP_CHECK(failures, !result && result.status == utf8::check_result::error::invalid && result.offset == 1);
+    UTF8PP_CHECK(failures, rejected.size() == 0);
+
+    utf8::string const accepted(u8"välid", result);
+    UTF8PP_CHECK(failures, result && result.offset == 6 && accepted.length() == 5);
+
+    // NULL bytes count as invalid, std::string isn't cut at them
+    std::string const with_nul("a\0b", 3);
+    utf8::string const checked_nul(with_nul, result);
+    UTF8PP_CHECK(failures, !result && result.offset == 1);
+    UTF8PP_CHECK(failures, equals(utf8::string(with_nul, utf8::replace_invalid), "a\xEF\xBF\xBD" "b"));
+    UTF8PP_CHECK(failures, equals(utf8::string(utf8::string_view(with_nul.data(), 3), utf8::skip_invalid), "ab"));
+
+    // allocation failures are reported as such, not as invalid input
+    throwing_resource throwing;
+    std::string const long_text(100, 'x');
+    utf8::string const unallocated(long_text, result, &throwing);
+    UTF8PP_CHECK(failures, !result && result.status == utf8::check_result::error::no_memory);
+    UTF8PP_CHECK(failures, unallocated.size() == 0);
+    utf8::string const short_text("fits", result, &throwing);
+    UTF8PP_CHECK(failures, result && short_text.size() == 4);
+
+    // random errors in text long enough for the vector kernels
+    std::mt19937 rng(17);
+    std::string const valid[] = { "plain ascii text ", u8"ümläüte ", u8"中文 ", u8"😀 " };
+    std::string const invalid[] = { "\xC0\xAF", "\xED\xA0\x80", "\xE2\x82", "\x80", "\xF5", "\xF0\x9F\x98", std::string(1, '\0') };
+    for (int round = 0; round < 200; ++round)
+    {
+        // about one piece in five is invalid
+        std::string bytes;
+        std::size_t const count = rng() % 60;
+        for (std::size_t n = 0; n < count; ++n)
+            bytes += rng() % 5 ? valid[rng() % 4] : invalid[rng() % 7];
+
+        std::size_t error;
+        UTF8PP_CHECK(failures, equals(utf8::string(bytes, utf8::replace_invalid), reference(bytes, true, error)));
+        UTF8PP_CHECK(failures, equals(utf8::string(bytes, utf8::skip_invalid), reference(bytes, false, error)));
+
+        utf8::string const checked(bytes, result);
+        UTF8PP_CHECK(failures, result.offset == error);
+        UTF8PP_CHECK(failures, error == bytes.size() ? (result && equals(checked, bytes)) : (!result && checked.size() == 0));
+    }
+
+    return failures;
+}
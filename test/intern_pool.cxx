@@ -0,0 +1,155 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "tests.hxx"
+
+#include "core/string.hxx"
+#include "core/string_view.hxx"
+#include "core/intern_pool.hxx"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+unsigned test_comparison()
+{
+    unsigned failures = 0;
+
+    // byte order is code point order
+    utf8::string const a("abc"), b(u8"abä"), c(u8"ab€"), d(u8"ab\U0001F600"), prefix("ab");
+    UTF8PP_CHECK(failures, a < b && b < c && c < d && prefix < a);
+    UTF8PP_CHECK(failures, d > c && a >= a && a <= a && !(a < a) && a.compare(a) == 0);
+    UTF8PP_CHECK(failures, a.compare(prefix) > 0 && prefix.compare(a) < 0);
+    UTF8PP_CHECK(failures, a == utf8::string("abc") && a != b && a != prefix);
+
+    // long strings, strings and views, and C strings
+    std::string const text(1000, 'x');
+    utf8::string const long_a(text), long_b(text + "y");
+    UTF8PP_CHECK(failures, long_a == utf8::string(text) && long_a != long_b && long_a < long_b);
+    UTF8PP_CHECK(failures, a == utf8::string_view("abc") && utf8::string_view("abd") > a && a == "abc" && "abc" == a);
+    UTF8PP_CHECK(failures, utf8::string_view() == utf8::string() && utf8::string_view() < utf8::string_view("a"));
+
+    // mixed comparisons compare views instead of constructing strings, so invalid bytes don't throw
+    bool thrown = false;
+    try
+    {
+        UTF8PP_CHECK(failures, long_a != "\xC3" && "\xFF" != a && a < "\xFF" && long_a == text.c_str());
+        UTF8PP_CHECK(failures, long_a == utf8::string_view(text) && utf8::string_view(text) <= long_a && long_b > utf8::string_view(text));
+    }
+    catch (std::invalid_argument const &) { thrown = true; }
+    UTF8PP_CHECK(failures, !thrown);
+
+    // views and C strings in both orders
+    utf8::string_view const view("abc");
+    UTF8PP_CHECK(failures, view == "abc" && "abc" == view && view != "abd" && "abd" != view);
+    UTF8PP_CHECK(failures, view < "abd" && "abb" < view && view <= "abc" && "abc" <= view);
+    UTF8PP_CHECK(failures, view > "ab" && "abd" > view && view >= "abc" && "abc" >= view);
+
+    // sorting
+    std::vector<utf8::string> sorted = { d, prefix, c, a, b };
+    std::sort(sorted.begin(), sorted.end());
+    UTF8PP_CHECK(failures, sorted == (std::vector<utf8::string>{ prefix, a, b, c, d }));
+
+    // strings and views with the same bytes hash the same, different sizes rarely collide
+    std::hash<utf8::string> const hash_string;
+    std::hash<utf8::string_view> const hash_view;
+    std::unordered_set<std::size_t> hashes;
+    for (std::size_t size = 0; size <= text.size(); ++size)
+    {
+        utf8::string const str(text.substr(0, size));
+        UTF8PP_CHECK(failures, hash_string(str) == hash_view(utf8::string_view(text.data(), size)));
+        hashes.insert(hash_string(str));
+    }
+    UTF8PP_CHECK(failures, hashes.size() == text.size() + 1);
+    UTF8PP_CHECK(failures, hash_string(a) != hash_string(utf8::string("abd")));
+
+    std::unordered_map<utf8::string, int> map;
+    map[a] = 1;
+    map[b] = 2;
+    map[long_a] = 3;
+    UTF8PP_CHECK(failures, map.at(utf8::string("abc")) == 1 && map.at(utf8::string(text)) == 3 && map.size() == 3);
+
+    return failures;
+}
+
+unsigned test_intern_pool()
+{
+    unsigned failures = 0;
+
+    utf8::intern_pool pool(3);
+    utf8::interned const first = pool.intern(u8"grüße");
+    utf8::interned const second = pool.intern(utf8::string(u8"grüße"));
+    UTF8PP_CHECK(failures, first == second && first.bytes() == second.bytes() && pool.size() == 1);
+    UTF8PP_CHECK(failures, first.length() == 5 && first.str() == utf8::string(u8"grüße"));
+    UTF8PP_CHECK(failures, first.hash() == std::hash<utf8::string>()(first.str()));
+    UTF8PP_CHECK(failures, pool.find(u8"grüße") == first && pool.find("missing") == utf8::interned());
+    UTF8PP_CHECK(failures, pool.intern("") != first && pool.intern("").empty() && pool.size() == 2);
+
+    utf8::interned const empty;
+    UTF8PP_CHECK(failures, empty.empty() && empty.size() == 0 && utf8::string_view(empty).empty());
+
+    bool thrown = false;
+    try { pool.intern("\xC0\xAF"); }
+    catch (std::invalid_argument const &) { thrown = true; }
+    UTF8PP_CHECK(failures, thrown && pool.size() == 2);
+
+    // threads interning overlapping values get the same handles
+    std::vector<std::string> values;
+    for (unsigned n = 0; n < 2000; ++n)
+        values.push_back("tag-" + std::to_string(n) + (n % 3 ? "" : u8"-äöü-a longer value that lives on the heap"));
+
+    unsigned const threads = 4;
+    std::vector<std::vector<utf8::interned>> handles(threads);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t]() {
+            for (unsigned n = 0; n < values.size(); ++n)
+                handles[t].push_back(pool.intern(utf8::string_view(values[(n * (t + 1)) % values.size()])));
+        });
+    }
+    for (std::thread & worker : workers)
+        worker.join();
+
+    UTF8PP_CHECK(failures, pool.size() == values.size() + 2);
+    std::map<std::string, utf8::interned> canonical;
+    bool consistent = true;
+    for (std::vector<utf8::interned> const & list : handles)
+    {
+        for (utf8::interned const & handle : list)
+        {
+            std::string const key(reinterpret_cast<char const *>(handle.bytes()), handle.size());
+            auto const inserted = canonical.insert(std::make_pair(key, handle));
+            consistent = consistent && inserted.first->second == handle;
+        }
+    }
+    UTF8PP_CHECK(failures, consistent && canonical.size() == values.size());
+
+    std::unordered_set<utf8::interned> set(handles[0].begin(), handles[0].end());
+    UTF8PP_CHECK(failures, set.size() == values.size());
+
+    return failures;
+}
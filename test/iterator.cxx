@@ -0,0 +1,70 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tests.hxx"
+
+#include "core/string.hxx"
+#include "core/string_view.hxx"
+
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+unsigned test_iterator()
+{
+    unsigned failures = 0;
+
+    static_assert(std::is_same<std::iterator_traits<utf8::string::const_iterator>::iterator_category,
+        std::bidirectional_iterator_tag>::value, "utf8::string iterators should be bidirectional");
+
+    utf8::string const str(u8"/home/félix/€uro/\U0001F600.txt");
+    std::vector<utf8::value_t> forward(str.begin(), str.end());
+    UTF8PP_CHECK(failures, forward.size() == str.length());
+
+    // reverse iteration yields the same characters
+    std::vector<utf8::value_t> const backward(str.rbegin(), str.rend());
+    UTF8PP_CHECK(failures, std::equal(forward.rbegin(), forward.rend(), backward.begin()));
+
+    // stepping back and forth keeps the offsets and positions
+    utf8::string::const_iterator it = str.end();
+    UTF8PP_CHECK(failures, it.offset() == str.size() && it.position() == str.length() && *it == utf8::END_OF_STRING);
+    std::size_t position = str.length();
+    while (it != str.begin())
+    {
+        utf8::string::const_iterator const previous = it--;
+        --position;
+        UTF8PP_CHECK(failures, *it == forward[position] && it.position() == position);
+        UTF8PP_CHECK(failures, std::next(it) == previous && it.offset() < previous.offset());
+    }
+    UTF8PP_CHECK(failures, it.offset() == 0 && std::distance(str.begin(), str.end()) == 22);
+
+    // the last path separator is found from the back
+    utf8::string::const_reverse_iterator const separator = std::find(str.rbegin(), str.rend(), '/');
+    utf8::string::const_iterator const name = separator.base();
+    UTF8PP_CHECK(failures, *name == 0x1F600 && name.position() == 17 && name.offset() == 20);
+    UTF8PP_CHECK(failures, utf8::string_view(str).substr(name.position()).size() == str.size() - name.offset());
+
+    // the same on views
+    utf8::string_view const view(u8"a/b/çd");
+    UTF8PP_CHECK(failures, std::find(view.rbegin(), view.rend(), '/').base().offset() == 4);
+    UTF8PP_CHECK(failures, *view.rbegin() == 'd' && *std::next(view.rbegin()) == 0xE7);
+
+    return failures;
+}
@@ -0,0 +1,164 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "tests.hxx"
+
+#include "core/line_reader.hxx"
+#include "core/memory_resource.hxx"
+
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstring>
+
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // the lines std::getline finds
+    std::vector<std::string> reference(std::string const & text)
+    {
+        std::vector<std::string> lines;
+        std::istringstream is(text);
+        std::string line;
+        while (std::getline(is, line))
+            lines.push_back(line);
+        return lines;
+    }
+
+    std::vector<std::string> read_all(utf8::line_reader & reader)
+    {
+        std::vector<std::string> lines;
+        utf8::string_view line;
+        while (reader.next(line))
+        {
+            if (line.length() != utf8::string(line).length())
+                lines.push_back("(wrong length)");
+            lines.push_back(std::string(reinterpret_cast<char const *>(line.bytes()), line.size()));
+        }
+        return lines;
+    }
+
+    // number of lines read before the reader throws
+    std::size_t lines_before_error(std::string const & text, std::size_t blocksize)
+    {
+        std::istringstream is(text);
+        utf8::line_reader reader(is, '\n', blocksize);
+        utf8::string_view line;
+        try
+        {
+            while (reader.next(line))
+                ;
+        }
+        catch (std::invalid_argument const &)
+        {
+            return static_cast<std::size_t>(reader.line_number());
+        }
+        return static_cast<std::size_t>(-1);
+    }
+}
+
+unsigned test_line_reader()
+{
+    unsigned failures = 0;
+
+    // random lines with multi byte characters at every position of small blocks,
+    // empty lines, carriage returns and lines longer than a block
+    std::mt19937 rng(21);
+    char const * const pieces[] = { "a", "bc", u8"é", u8"€", u8"\U0001F600", "\n", "\n\n", "\r\n", "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" };
+    for (unsigned round = 0; round < 200; ++round)
+    {
+        std::string text;
+        std::size_t const count = rng() % 100;
+        for (std::size_t n = 0; n < count; ++n)
+            text += pieces[rng() % (sizeof(pieces) / sizeof(pieces[0]))];
+
+        std::size_t const blocksize = 16 + rng() % 50;
+        std::istringstream is(text);
+        utf8::line_reader reader(is, '\n', blocksize);
+        std::vector<std::string> const lines = read_all(reader);
+        UTF8PP_CHECK(failures, lines == reference(text));
+        UTF8PP_CHECK(failures, reader.line_number() == lines.size());
+    }
+
+    // other delimiters and owning copies
+    std::istringstream fields(u8"grüße;€;;last");
+    utf8::line_reader reader(fields, ';');
+    utf8::arena_resource arena;
+    utf8::string field(nullptr, &arena);
+    std::vector<std::string> copied;
+    while (reader.next(field))
+        copied.push_back(std::string(reinterpret_cast<char const *>(field.bytes()), field.size()));
+    UTF8PP_CHECK(failures, copied == (std::vector<std::string>{ u8"grüße", u8"€", "", "last" }));
+    UTF8PP_CHECK(failures, field.resource() == &arena);
+
+    // invalid bytes stop the reader at their line, also when cut by a block boundary
+    for (std::size_t offset = 10; offset < 40; ++offset)
+    {
+        std::string text(60, 'a');
+        for (std::size_t n = 4; n < text.size(); n += 5)
+            text[n] = '\n';
+        std::string broken(text);
+        broken[offset] = '\xFF';
+        UTF8PP_CHECK(failures, lines_before_error(broken, 16) == offset / 5);
+
+        // a sequence cut short
+        broken = text;
+        broken.replace(offset, 1, "\xE2\x82");
+        broken[offset + 2] = broken[offset + 2] == '\n' ? '\n' : 'a';
+        UTF8PP_CHECK(failures, lines_before_error(broken, 16) == offset / 5);
+        broken[offset] = '\0';
+        UTF8PP_CHECK(failures, lines_before_error(broken, 16) == offset / 5);
+    }
+    UTF8PP_CHECK(failures, lines_before_error("ok\nend\xC3", 16) == 1);
+
+    // file descriptors
+    std::string text;
+    for (unsigned n = 0; n < 5000; ++n)
+        text += "line " + std::to_string(n) + (n % 7 ? u8" äöü\n" : "\n");
+    test_file const fixture("utf8pp_line_reader.txt");
+    fixture.write(text);
+#ifdef _WIN32
+    int const fd = _open(fixture.path(), _O_RDONLY | _O_BINARY);
+#else
+    int const fd = open(fixture.path(), O_RDONLY);
+#endif
+    UTF8PP_CHECK(failures, fd >= 0);
+    if (fd >= 0)
+    {
+        utf8::line_reader file_reader(fd, '\n', 4096);
+        UTF8PP_CHECK(failures, read_all(file_reader) == reference(text));
+#ifdef _WIN32
+        _close(fd);
+#else
+        close(fd);
+#endif
+    }
+
+    return failures;
+}
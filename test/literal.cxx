@@ -0,0 +1,75 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tests.hxx"
+
+#include "core/literal.hxx"
+#include "core/string.hxx"
+#include "core/string_view.hxx"
+
+#include <string>
+
+using namespace utf8::literals;
+
+namespace
+{
+    // checked by the compiler
+    constexpr utf8::literal shades = u8"(-■_■)"_u8;
+    static_assert(shades.length() == 6 && shades.size() == 10, "wrong length of a literal");
+    static_assert(u8"\U0010FFFF߿"_u8.length() == 3, "wrong length of a literal");
+    static_assert(""_u8.empty(), "empty literal not empty");
+
+    // long enough to be split a few times
+    constexpr utf8::literal long_literal =
+        u8"Das ist ein längerer Text mit Umlauten: äöü ÄÖÜ ß, Zeichen wie € und ✓, "
+        u8"etwas Chinesisch 中文字符 und ein paar Emoji 😀😁😂🤣, damit die Teilung "
+        u8"auch an Grenzen von Zeichen mit vier Bytes geprüft wird. Noch ein Satz: "
+        u8"Größere Literale werden rekursiv halbiert, also bleibt die Tiefe gering."_u8;
+    static_assert(long_literal.length() == 281 && long_literal.size() == 316, "wrong length of a long literal");
+}
+
+unsigned test_literal()
+{
+    unsigned failures = 0;
+
+    // literals are validated views
+    utf8::string_view const view = shades;
+    UTF8PP_CHECK(failures, view.validated() && view.length() == 6 && view[2] == 0x25A0);
+    UTF8PP_CHECK(failures, utf8::string_view(long_literal).length() == utf8::string_view(long_literal.c_str()).length());
+
+    // they can be read wherever a view is
+    UTF8PP_CHECK(failures, utf8::string(u8"(-■_■) with shades").find(shades).offset() == 0);
+    utf8::string const copy(shades);
+    UTF8PP_CHECK(failures, copy.length() == 6 && copy.size() == 10);
+
+    std::size_t characters = 0;
+    for (utf8::value_t c : long_literal)
+        characters += c ? 1 : 0;
+    UTF8PP_CHECK(failures, characters == long_literal.length());
+
+    // outside of constant expressions invalid literals throw
+    UTF8PP_CHECK(failures, throws_invalid_argument([]() { "\xC0\xAF"_u8; }));
+    UTF8PP_CHECK(failures, throws_invalid_argument([]() { "surrogate \xED\xA0\x80"_u8; }));
+    UTF8PP_CHECK(failures, throws_invalid_argument([]() { "a\0b"_u8; }));
+    UTF8PP_CHECK(failures, throws_invalid_argument([]() { "cut \xF0\x9F\x98"_u8; }));
+    std::string const invalid = std::string(200, 'a') + "\xF4\x90\x80\x80" + std::string(200, 'b');
+    UTF8PP_CHECK(failures, throws_invalid_argument([&]() { utf8::literals::operator "" _u8(invalid.c_str(), invalid.size()); }));
+
+    return failures;
+}
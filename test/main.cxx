@@ -19,6 +19,8 @@
 
 #define UTF8PP_TEST
 
+#include "tests.hxx"
+
 #include "core/string.hxx"
 #include "conversion/encoding_cast.hxx"
 using utf8::encoding_cast;
@@ -43,6 +45,32 @@ int main()
     auto eurou = encoding_cast<utf8::string>(eurow);
     
     std::cout << eurou << "\n";
-    
-    return 0;
+
+    unsigned failures = 0;
+    failures += test_validation();
+    failures += test_parallel_validation();
+    failures += test_offset_index();
+    failures += test_short_strings();
+    failures += test_string_view();
+    failures += test_encoding();
+    failures += test_decoding();
+    failures += test_stream_decoder();
+    failures += test_mapped_file();
+    failures += test_iterator();
+    failures += test_search();
+    failures += test_split();
+    failures += test_memory_resource();
+    failures += test_literal();
+    failures += test_error_policy();
+    failures += test_ascii();
+    failures += test_concat();
+    failures += test_comparison();
+    failures += test_intern_pool();
+    failures += test_line_reader();
+    failures += test_normalization();
+    failures += test_case_mapping();
+
+    if (failures)
+        std::cerr << failures << " checks failed\n";
+    return failures ? 1 : 0;
 }
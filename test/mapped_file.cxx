@@ -0,0 +1,105 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tests.hxx"
+
+#include "core/mapped_file.hxx"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <cstdio>
+
+namespace
+{
+    // true if loading the file fails with the given offset in the message
+    bool rejected_at(test_file const & fixture, std::size_t offset)
+    {
+        try { utf8::mapped_file file(fixture.path()); }
+        catch (std::invalid_argument const & e)
+        {
+            return std::string(e.what()).find("offset " + std::to_string(offset) + ".") != std::string::npos;
+        }
+        return false;
+    }
+}
+
+unsigned test_mapped_file()
+{
+    unsigned failures = 0;
+    test_file const fixture("utf8pp_mapped_file.txt");
+
+    // a multi byte character across the page boundary
+    std::string const content = std::string(4095, 'a') + u8"€" + std::string(100, 'b');
+    fixture.write(content);
+    {
+        utf8::mapped_file file(fixture.path());
+        UTF8PP_CHECK(failures, file.size() == content.size() && file.length() == 4196);
+        UTF8PP_CHECK(failures, file[4095] == 0x20AC && file[4096] == 'b');
+        UTF8PP_CHECK(failures, file.view().validated() && file.view().substr(4094, 3).size() == 5);
+
+        std::size_t count = 0;
+        for (utf8::value_t c : file)
+            count += c ? 1 : 0;
+        UTF8PP_CHECK(failures, count == 4196);
+
+        utf8::mapped_file moved(std::move(file));
+        UTF8PP_CHECK(failures, file.empty() && moved.length() == 4196);
+    }
+
+    // invalid bytes right before, at and behind the page boundaries
+    std::size_t const boundaries[] = { 4096, 65536 };
+    for (std::size_t boundary : boundaries)
+    {
+        for (std::size_t offset = boundary - 2; offset <= boundary + 1; ++offset)
+        {
+            std::string bytes(boundary * 2, 'x');
+            bytes[offset] = '\xFF';
+            fixture.write(bytes);
+            UTF8PP_CHECK(failures, rejected_at(fixture, offset));
+
+            // a sequence cut short by the page boundary
+            bytes[offset] = '\xE2';
+            bytes[offset + 1] = '\x82';
+            fixture.write(bytes);
+            UTF8PP_CHECK(failures, rejected_at(fixture, offset));
+        }
+
+        // an unfinished sequence at the very end of a file of whole pages
+        std::string bytes(boundary, 'y');
+        bytes[boundary - 1] = '\xC3';
+        fixture.write(bytes);
+        UTF8PP_CHECK(failures, rejected_at(fixture, boundary - 1));
+    }
+
+    // NULL bytes, empty and missing files
+    fixture.write(std::string("ab\0c", 4));
+    UTF8PP_CHECK(failures, rejected_at(fixture, 2));
+    fixture.write(std::string());
+    UTF8PP_CHECK(failures, utf8::mapped_file(fixture.path()).empty());
+
+    std::remove(fixture.path());
+    bool thrown = false;
+    try { utf8::mapped_file file(fixture.path()); }
+    catch (std::runtime_error const &) { thrown = true; }
+    UTF8PP_CHECK(failures, thrown);
+
+    return failures;
+}
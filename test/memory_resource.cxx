@@ -0,0 +1,117 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define UTF8PP_TEST
+
+#include "tests.hxx"
+
+#include "core/string.hxx"
+#include "core/memory_resource.hxx"
+#include "conversion/encoding_cast.hxx"
+
+#include <cstring>
+#include <string>
+#include <utility>
+
+namespace
+{
+    bool same(utf8::string const & a, utf8::string const & b)
+    {
+        return a.length() == b.length() && a.size() == b.size() && !std::memcmp(a.bytes(), b.bytes(), a.size());
+    }
+}
+
+unsigned test_memory_resource()
+{
+    unsigned failures = 0;
+    char const * const text = u8"a text long enough for the heap: äöü €";
+
+    // short strings don't allocate, long ones use their resource
+    counting_resource counting;
+    {
+        utf8::string small(u8"grüß", &counting);
+        utf8::string large(text, &counting);
+        UTF8PP_CHECK(failures, small.resource() == &counting && large.resource() == &counting);
+        UTF8PP_CHECK(failures, counting.allocations == 1);
+
+        // growing short strings keep the resource
+        for (int n = 0; n < 40; ++n)
+            small.push_back(U'ß');
+        UTF8PP_CHECK(failures, small.resource() == &counting && small.length() == 44);
+        UTF8PP_CHECK(failures, large.get_allocator() == utf8::string::allocator_type(&counting));
+
+        // copies use the default resource unless told otherwise, moves keep it
+        utf8::string copy(large);
+        UTF8PP_CHECK(failures, copy.resource() == utf8::resource_or_default(nullptr) && same(copy, large));
+        utf8::string const moved(std::move(copy));
+        UTF8PP_CHECK(failures, moved.resource() == utf8::resource_or_default(nullptr));
+
+        // assignment keeps the resource of the target
+        std::size_t const before = counting.allocations;
+        large = moved;
+        UTF8PP_CHECK(failures, large.resource() == &counting && counting.allocations == before + 1);
+
+        // concatenation uses the left operand's resource
+        utf8::string const sum = large + moved;
+        UTF8PP_CHECK(failures, sum.resource() == &counting && sum.length() == 2 * moved.length());
+        UTF8PP_CHECK(failures, (moved + large).resource() == utf8::resource_or_default(nullptr));
+    }
+    UTF8PP_CHECK(failures, counting.allocations > 0 && counting.allocations == counting.deallocations);
+
+    // the arena takes blocks from its upstream resource and gives them back all at once
+    counting_resource upstream;
+    {
+        utf8::arena_resource arena(1024, &upstream);
+        for (int n = 0; n < 100; ++n)
+        {
+            utf8::string str(text, &arena);
+            str += str;
+            UTF8PP_CHECK(failures, str.resource() == &arena && str.length() == 76);
+        }
+        UTF8PP_CHECK(failures, arena.blocks() == upstream.allocations && upstream.deallocations == 0);
+
+        // requests larger than a block get their own block
+        void * const large = arena.allocate(5000, 64);
+        UTF8PP_CHECK(failures, reinterpret_cast<std::size_t>(large) % 64 == 0);
+        arena.release();
+        UTF8PP_CHECK(failures, upstream.allocations == upstream.deallocations);
+    }
+    UTF8PP_CHECK(failures, upstream.allocations == upstream.deallocations);
+
+    // an initial buffer is used before any block and reused after release()
+    unsigned char buffer[512];
+    utf8::arena_resource buffered(buffer, sizeof(buffer), &upstream);
+    std::size_t const before = upstream.allocations;
+    for (int n = 0; n < 3; ++n)
+    {
+        utf8::string const str(text, &buffered);
+        UTF8PP_CHECK(failures, str.bytes() >= buffer && str.bytes() < buffer + sizeof(buffer));
+        buffered.release();
+    }
+    UTF8PP_CHECK(failures, upstream.allocations == before);
+
+    // the converters allocate from the resource they are given
+    utf8::arena_resource arena;
+    utf8::string const converted = utf8::encoding_cast<utf8::string>(std::u32string(U"wide text: \U0001F600 and some more"), &arena);
+    UTF8PP_CHECK(failures, converted.resource() == &arena && converted.length() == 26);
+    UTF8PP_CHECK(failures, utf8::encoding_cast<utf8::string>(std::wstring(L"wide text, but from wchar_t"), &arena).resource() == &arena);
+    UTF8PP_CHECK(failures, utf8::encoding_cast<std::u32string>(converted) == U"wide text: \U0001F600 and some more");
+
+    return failures;
+}
@@ -0,0 +1,122 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tests.hxx"
+
+#include "core/normalization.hxx"
+#include "core/memory_resource.hxx"
+
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    struct normalization_case
+    {
+        char const * input;
+        char const * nfc;
+        char const * nfd;
+        char const * nfkc;
+        char const * nfkd;
+    };
+
+    // mostly taken from UAX #15 and NormalizationTest.txt
+    normalization_case const cases[] = {
+        { u8"abc", u8"abc", u8"abc", u8"abc", u8"abc" },
+        { u8"\u00C5", u8"\u00C5", u8"A\u030A", u8"\u00C5", u8"A\u030A" },
+        // singletons
+        { u8"\u212B", u8"\u00C5", u8"A\u030A", u8"\u00C5", u8"A\u030A" },
+        { u8"\u2126", u8"\u03A9", u8"\u03A9", u8"\u03A9", u8"\u03A9" },
+        // canonical ordering
+        { u8"\u1E0B\u0323", u8"\u1E0D\u0307", u8"d\u0323\u0307", u8"\u1E0D\u0307", u8"d\u0323\u0307" },
+        { u8"q\u0307\u0323", u8"q\u0323\u0307", u8"q\u0323\u0307", u8"q\u0323\u0307", u8"q\u0323\u0307" },
+        { u8"\u00C5\u0323", u8"\u1EA0\u030A", u8"A\u0323\u030A", u8"\u1EA0\u030A", u8"A\u0323\u030A" },
+        { u8"\u1E9B\u0323", u8"\u1E9B\u0323", u8"\u017F\u0323\u0307", u8"\u1E69", u8"s\u0323\u0307" },
+        // Hangul
+        { u8"\u1100\u1161\u11A8", u8"\uAC01", u8"\u1100\u1161\u11A8", u8"\uAC01", u8"\u1100\u1161\u11A8" },
+        { u8"\uAC00\u11A8", u8"\uAC01", u8"\u1100\u1161\u11A8", u8"\uAC01", u8"\u1100\u1161\u11A8" },
+        // compatibility characters
+        { u8"\uFB01", u8"\uFB01", u8"\uFB01", u8"fi", u8"fi" },
+        { u8"\uFF76\uFF9E", u8"\uFF76\uFF9E", u8"\uFF76\uFF9E", u8"\u30AC", u8"\u30AB\u3099" },
+        { u8"\u2460 ", u8"\u2460 ", u8"\u2460 ", u8"1 ", u8"1 " },
+        // composition exclusion
+        { u8"\u0958", u8"\u0915\u093C", u8"\u0915\u093C", u8"\u0915\u093C", u8"\u0915\u093C" },
+        // a leading non-starter doesn't combine
+        { u8"\u0301a", u8"\u0301a", u8"\u0301a", u8"\u0301a", u8"\u0301a" },
+        { u8"", u8"", u8"", u8"", u8"" }
+    };
+
+    std::string bytes(utf8::string const & str)
+    {
+        return std::string(reinterpret_cast<char const *>(str.bytes()), str.size());
+    }
+
+    bool check(char const * input, utf8::normalization_form form, char const * expected)
+    {
+        return bytes(utf8::normalize(input, form)) == expected
+            && utf8::is_normalized(input, form) == (std::string(input) == expected);
+    }
+}
+
+unsigned test_normalization()
+{
+    unsigned failures = 0;
+
+    for (normalization_case const & c : cases)
+    {
+        UTF8PP_CHECK(failures, check(c.input, utf8::normalization_form::nfc, c.nfc));
+        UTF8PP_CHECK(failures, check(c.input, utf8::normalization_form::nfd, c.nfd));
+        UTF8PP_CHECK(failures, check(c.input, utf8::normalization_form::nfkc, c.nfkc));
+        UTF8PP_CHECK(failures, check(c.input, utf8::normalization_form::nfkd, c.nfkd));
+    }
+
+    // the changes start after a long normalized prefix and span many chunks
+    std::string decomposed(1000, 'x'), composed(1000, 'x');
+    for (unsigned n = 0; n < 500; ++n)
+    {
+        decomposed += n % 2 ? u8"e\u0301" : u8"\u1100\u1161";
+        composed += n % 2 ? u8"\u00E9" : u8"\uAC00";
+    }
+    utf8::string_view const decomposed_view(decomposed);
+    UTF8PP_CHECK(failures, bytes(utf8::normalize(decomposed_view)) == composed);
+    UTF8PP_CHECK(failures, !utf8::is_normalized(decomposed_view));
+    UTF8PP_CHECK(failures, utf8::is_normalized(decomposed_view, utf8::normalization_form::nfd));
+    UTF8PP_CHECK(failures, utf8::is_normalized(utf8::string_view(composed)));
+    utf8::string const nfd = utf8::normalize(utf8::string_view(composed), utf8::normalization_form::nfd);
+    UTF8PP_CHECK(failures, utf8::is_normalized(nfd, utf8::normalization_form::nfd));
+    UTF8PP_CHECK(failures, bytes(utf8::normalize(nfd)) == composed);
+
+    // normalized strings are passed through without copying
+    utf8::string normalized(composed);
+    utf8::byte_t const * const storage = normalized.bytes();
+    utf8::string const moved = utf8::normalize(std::move(normalized));
+    UTF8PP_CHECK(failures, moved.bytes() == storage);
+    UTF8PP_CHECK(failures, bytes(utf8::normalize(utf8::string(decomposed))) == composed);
+
+    // the result allocates from the given resource
+    utf8::arena_resource arena;
+    UTF8PP_CHECK(failures, utf8::normalize(decomposed_view, utf8::normalization_form::nfc, &arena).resource() == &arena);
+
+    bool thrown = false;
+    try { utf8::is_normalized("\xC3"); }
+    catch (std::invalid_argument const &) { thrown = true; }
+    UTF8PP_CHECK(failures, thrown);
+
+    return failures;
+}
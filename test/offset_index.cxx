@@ -0,0 +1,112 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tests.hxx"
+
+#include "core/string.hxx"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+    // checks indexing and jumping iterators against the expected characters
+    unsigned check_access(utf8::string const & str, std::vector<utf8::value_t> const & expected)
+    {
+        unsigned failures = 0;
+        UTF8PP_CHECK(failures, str.length() == expected.size());
+
+        std::vector<utf8::value_t> iterated;
+        for (utf8::value_t c : str)
+            iterated.push_back(c);
+        UTF8PP_CHECK(failures, iterated == expected);
+
+        for (std::size_t index = 0; index < expected.size(); index += 1 + index % 13)
+        {
+            UTF8PP_CHECK(failures, str[static_cast<unsigned>(index)] == expected[index]);
+            UTF8PP_CHECK(failures, *(str.begin() + static_cast<unsigned>(index)) == expected[index]);
+        }
+
+        // jumps starting in the middle of the string
+        utf8::string::const_iterator it = str.begin();
+        std::size_t position = 0;
+        for (unsigned jump = 1; position + jump < expected.size(); jump *= 3)
+        {
+            it += jump;
+            position += jump;
+            UTF8PP_CHECK(failures, *it == expected[position]);
+        }
+        it += static_cast<unsigned>(expected.size());
+        UTF8PP_CHECK(failures, it == str.end());
+        return failures;
+    }
+}
+
+unsigned test_offset_index()
+{
+    unsigned failures = 0;
+    std::mt19937 rng(3);
+
+    utf8::value_t const alphabet[] = { 'a', 'Z', 0xE9, 0x3A9, 0x20AC, 0x4E2D, 0x1F600 };
+    std::size_t const letters = sizeof(alphabet) / sizeof(alphabet[0]);
+
+    utf8::string str;
+    std::vector<utf8::value_t> expected;
+    for (unsigned n = 0; n < 1000; ++n)
+    {
+        utf8::value_t const c = alphabet[rng() % letters];
+        str.push_back(c);
+        expected.push_back(c);
+    }
+    failures += check_access(str, expected);
+
+    // appends extend the index which has been built by now
+    for (unsigned n = 0; n < 300; ++n)
+    {
+        utf8::value_t const c = alphabet[rng() % letters];
+        str.push_back(c);
+        expected.push_back(c);
+    }
+    failures += check_access(str, expected);
+
+    utf8::string copy(str);
+    str += copy;
+    expected.insert(expected.end(), expected.begin(), expected.end());
+    failures += check_access(str, expected);
+
+    str += str;
+    expected.insert(expected.end(), expected.begin(), expected.end());
+    failures += check_access(str, expected);
+
+    // copies and moved strings keep working
+    utf8::string moved(std::move(copy));
+    failures += check_access(moved, std::vector<utf8::value_t>(expected.begin(), expected.begin() + 1300));
+    UTF8PP_CHECK(failures, copy.length() == 0);
+
+    // the table is allocated from the string's resource, copies bring it along into their resource
+    counting_resource counting, other;
+    utf8::string const fresh(utf8::string_view(str), &counting);
+    UTF8PP_CHECK(failures, counting.allocations == 1);
+    UTF8PP_CHECK(failures, fresh[1000] == expected[1000] && counting.allocations == 3);
+    utf8::string const copied(fresh, &other);
+    UTF8PP_CHECK(failures, other.allocations == 3 && copied[1000] == expected[1000] && other.allocations == 3);
+    UTF8PP_CHECK(failures, counting.allocations == 3);
+
+    return failures;
+}
@@ -0,0 +1,130 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tests.hxx"
+
+#include "core/string.hxx"
+#include "core/string_view.hxx"
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    // texts over small alphabets contain many partial and periodic matches
+    std::string random_text(std::mt19937 & rng, std::size_t characters, std::size_t letters)
+    {
+        char const * const alphabet[] = { "a", "b", u8"é", u8"€", "a", u8"\U0001F600" };
+        std::string text;
+        for (std::size_t n = 0; n < characters; ++n)
+            text += alphabet[rng() % letters];
+        return text;
+    }
+
+    std::size_t naive_find(std::string const & haystack, std::string const & needle, std::size_t from)
+    {
+        return from > haystack.size() ? utf8::match::npos : haystack.find(needle, from);
+    }
+
+    std::size_t naive_rfind(std::string const & haystack, std::string const & needle, std::size_t from)
+    {
+        std::size_t const found = haystack.rfind(needle, from);
+        return found == std::string::npos ? utf8::match::npos : found;
+    }
+
+    std::size_t naive_count(std::string const & haystack, std::string const & needle)
+    {
+        std::size_t result = 0;
+        for (std::size_t pos = haystack.find(needle); pos != std::string::npos; pos = haystack.find(needle, pos + needle.size()))
+            ++result;
+        return result;
+    }
+}
+
+unsigned test_search()
+{
+    unsigned failures = 0;
+
+    // byte offsets match std::string for short, long and periodic needles in both directions
+    std::mt19937 rng(5);
+    for (unsigned round = 0; round < 300; ++round)
+    {
+        std::size_t const letters = 2 + round % 5;
+        std::string const haystack = random_text(rng, rng() % 400, letters);
+        std::string needle = random_text(rng, 1 + rng() % 60, letters);
+        if (round % 3 == 0)
+        {
+            // a periodic needle cut from the haystack
+            std::string const period = random_text(rng, 1 + rng() % 3, letters);
+            needle.clear();
+            while (needle.size() < 40)
+                needle += period;
+        }
+        else if (round % 3 == 1 && !haystack.empty())
+        {
+            // a needle that is certainly there
+            utf8::string_view const view(haystack);
+            utf8::string_view const part = view.substr(rng() % view.length(), 1 + rng() % 70);
+            needle.assign(reinterpret_cast<char const *>(part.bytes()), part.size());
+        }
+
+        utf8::string const str(haystack);
+        std::size_t const from = rng() % (haystack.size() + 2);
+        UTF8PP_CHECK(failures, str.find(utf8::string_view(needle)).offset() == naive_find(haystack, needle, 0));
+        UTF8PP_CHECK(failures, str.find(utf8::string_view(needle), from).offset() == naive_find(haystack, needle, from));
+        UTF8PP_CHECK(failures, str.rfind(utf8::string_view(needle)).offset() == naive_rfind(haystack, needle, std::string::npos));
+        UTF8PP_CHECK(failures, str.rfind(utf8::string_view(needle), from).offset() == naive_rfind(haystack, needle, from));
+        UTF8PP_CHECK(failures, str.count(utf8::string_view(needle)) == naive_count(haystack, needle));
+    }
+
+    // characters, positions and offsets
+    utf8::string const path(u8"/home/félix/€uro/\U0001F600.txt");
+    utf8::match const last = path.rfind('/');
+    UTF8PP_CHECK(failures, last && last.offset() == 19 && last.position() == 16);
+    UTF8PP_CHECK(failures, path.find(0x20AC).position() == 12 && path.find(0x1F600).offset() == 20);
+    UTF8PP_CHECK(failures, path.find('/', last.offset() + 1).offset() == utf8::match::npos);
+    UTF8PP_CHECK(failures, !path.find(0x110000) && !path.find(0) && !path.contains('Z'));
+    UTF8PP_CHECK(failures, path.count('/') == 4 && path.count(u8"é") == 1 && path.contains(u8"€uro"));
+    UTF8PP_CHECK(failures, path.find("").offset() == 0 && path.rfind("").offset() == path.size());
+
+    // single byte counts take the SIMD path on long strings
+    std::string const commas = random_text(rng, 5000, 6) + "," + std::string(300, ',');
+    UTF8PP_CHECK(failures, utf8::string(commas).count(',') == 301);
+
+    // the first of a set of characters
+    utf8::string_view const csv(u8"naïve;price=5€,quantity");
+    UTF8PP_CHECK(failures, csv.find_first_of(";,=").offset() == 6);
+    UTF8PP_CHECK(failures, csv.find_first_of(u8"€=,").position() == 11);
+    UTF8PP_CHECK(failures, csv.find_first_of(u8"€,", 7).position() == 13);
+    UTF8PP_CHECK(failures, csv.find_first_of(u8"ï€").offset() == 2);
+    UTF8PP_CHECK(failures, !csv.find_first_of(u8"XYZ\U0001F600"));
+    std::string const long_text = std::string(100, 'x') + u8"€" + std::string(100, 'y') + "!";
+    UTF8PP_CHECK(failures, utf8::string(long_text).find_first_of(u8"!€").offset() == 100);
+    UTF8PP_CHECK(failures, utf8::string(long_text).find_first_of("!z").offset() == 203);
+
+    // invalid needles are rejected
+    bool thrown = false;
+    try { path.find("\xC3"); }
+    catch (std::invalid_argument const &) { thrown = true; }
+    UTF8PP_CHECK(failures, thrown);
+
+    return failures;
+}
@@ -0,0 +1,94 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tests.hxx"
+
+#include "core/string.hxx"
+#include "core/split.hxx"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::vector<std::string> fields(utf8::split_range const & range, std::vector<std::size_t> & lengths)
+    {
+        std::vector<std::string> result;
+        lengths.clear();
+        for (utf8::string_view const & field : range)
+        {
+            result.push_back(std::string(reinterpret_cast<char const *>(field.bytes()), field.size()));
+            lengths.push_back(field.validated() ? field.length() : utf8::match::npos);
+        }
+        return result;
+    }
+}
+
+unsigned test_split()
+{
+    unsigned failures = 0;
+    std::vector<std::size_t> lengths;
+
+    // fields are validated views with their lengths counted
+    utf8::string const line(u8"naïve;;€5;\U0001F600;");
+    std::vector<std::string> const expected = { u8"naïve", "", u8"€5", u8"\U0001F600", "" };
+    UTF8PP_CHECK(failures, fields(utf8::split(line, ";"), lengths) == expected);
+    UTF8PP_CHECK(failures, lengths == std::vector<std::size_t>({ 5, 0, 2, 1, 0 }));
+
+    // the fields point into the string
+    utf8::split_range::iterator it = utf8::split(line, ";").begin();
+    UTF8PP_CHECK(failures, it->bytes() == line.bytes() && (++it)->bytes() == line.bytes() + 7);
+
+    // multi byte and multi character delimiters
+    UTF8PP_CHECK(failures, fields(utf8::split(utf8::string(u8"a€b€€c"), u8"€"), lengths)
+        == std::vector<std::string>({ "a", "b", "", "c" }));
+    UTF8PP_CHECK(failures, fields(utf8::split(utf8::string_view(u8"x::ÿ::z"), "::"), lengths)
+        == std::vector<std::string>({ "x", u8"ÿ", "z" }));
+    UTF8PP_CHECK(failures, lengths == std::vector<std::size_t>({ 1, 1, 1 }));
+
+    // no delimiter and empty texts are a single field
+    UTF8PP_CHECK(failures, fields(utf8::split(utf8::string_view(u8"äöü"), ","), lengths)
+        == std::vector<std::string>({ u8"äöü" }) && lengths[0] == 3);
+    UTF8PP_CHECK(failures, fields(utf8::split(utf8::string_view(""), ","), lengths) == std::vector<std::string>({ "" }));
+
+    // long fields take the SIMD path
+    std::string long_line;
+    std::vector<std::string> long_fields;
+    for (std::size_t n = 0; n < 20; ++n)
+    {
+        long_fields.push_back(std::string(n * 7, 'x') + u8"é" + std::string(n, 'y'));
+        long_line += (n ? "," : "") + long_fields.back();
+    }
+    UTF8PP_CHECK(failures, fields(utf8::split(utf8::string(long_line), ","), lengths) == long_fields);
+    for (std::size_t n = 0; n < 20; ++n)
+        UTF8PP_CHECK(failures, lengths[n] == n * 8 + 1);
+
+    // invalid input
+    bool thrown = false;
+    try { utf8::split(utf8::string_view("a\xFF,b"), ","); }
+    catch (std::invalid_argument const &) { thrown = true; }
+    UTF8PP_CHECK(failures, thrown);
+    thrown = false;
+    try { utf8::split(line, ""); }
+    catch (std::invalid_argument const &) { thrown = true; }
+    UTF8PP_CHECK(failures, thrown);
+
+    return failures;
+}
@@ -0,0 +1,99 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tests.hxx"
+
+#include "core/stream_decoder.hxx"
+
+#include <algorithm>
+#include <string>
+
+namespace
+{
+    // feeds the stream in chunks of the given sizes (the last one is repeated)
+    bool decode(std::string const & stream, std::size_t first, std::size_t rest, std::uint64_t & length, std::uint64_t & offset)
+    {
+        utf8::stream_decoder decoder;
+        std::uint64_t counted = 0;
+        std::size_t pos = 0, chunk = first;
+        while (pos < stream.size())
+        {
+            chunk = std::min(chunk, stream.size() - pos);
+            utf8::stream_decoder::chunk_result const result = decoder.feed(stream.data() + pos, chunk);
+            if (!result.valid || decoder.carried() > 3)
+            {
+                offset = result.offset;
+                return false;
+            }
+            counted += result.length;
+            pos += chunk;
+            chunk = rest;
+        }
+
+        utf8::stream_decoder::chunk_result const result = decoder.finish();
+        offset = result.offset;
+        length = decoder.length();
+        return result.valid && counted == length && decoder.position() == stream.size();
+    }
+}
+
+unsigned test_stream_decoder()
+{
+    unsigned failures = 0;
+
+    // every way to split the stream in two, and single bytes
+    std::string const text(u8"aä€\U0001F600zࠀ\U0010FFFF!");
+    for (std::size_t first = 0; first <= text.size(); ++first)
+    {
+        std::uint64_t length = 0, offset = 0;
+        UTF8PP_CHECK(failures, decode(text, first, text.size(), length, offset) && length == 8);
+    }
+    std::uint64_t length = 0, offset = 0;
+    UTF8PP_CHECK(failures, decode(text, 1, 1, length, offset) && length == 8);
+    UTF8PP_CHECK(failures, decode(std::string(1000, 'x') + text, 7, 3, length, offset) && length == 1008);
+    UTF8PP_CHECK(failures, decode(std::string("a\0b", 3), 2, 1, length, offset) && length == 3);
+
+    // errors are reported at the offset of the invalid sequence, wherever the chunks end
+    std::string const invalid[] = {
+        "abc\xE2\x82" "d",       // sequence cut short
+        "abc\xE0\x80\x80",       // overlong
+        "abc\xED\xA0\x80",       // surrogate
+        "abc\xF4\x90\x80\x80",   // above U+10FFFF
+        "abc\x80",               // lonely continuation byte
+        "abc\xF0\x9F\x98"        // unfinished at the end of the stream
+    };
+    for (std::string const & stream : invalid)
+    {
+        for (std::size_t first = 1; first <= stream.size(); ++first)
+        {
+            UTF8PP_CHECK(failures, !decode(stream, first, 1, length, offset) && offset == 3);
+            UTF8PP_CHECK(failures, !decode(stream, first, stream.size(), length, offset) && offset == 3);
+        }
+    }
+
+    // invalid prefixes are reported with the chunk that contains them
+    utf8::stream_decoder decoder;
+    UTF8PP_CHECK(failures, decoder.feed("ab\xE0", 3).valid && decoder.carried() == 1);
+    UTF8PP_CHECK(failures, !decoder.feed("\x80", 1).valid && decoder.failed());
+    UTF8PP_CHECK(failures, !decoder.feed("cd", 2).valid);
+    decoder.reset();
+    UTF8PP_CHECK(failures, decoder.feed("cd", 2).valid && decoder.length() == 2);
+
+    return failures;
+}
@@ -0,0 +1,82 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tests.hxx"
+
+#include "core/string.hxx"
+
+#include <functional>
+#include <string>
+
+namespace
+{
+    // true if the bytes are stored inside the object itself
+    bool is_local(utf8::string const & str)
+    {
+        utf8::byte_t const * object = reinterpret_cast<utf8::byte_t const *>(&str);
+        std::less_equal<utf8::byte_t const *> before;
+        return before(object, str.bytes()) && before(str.bytes() + str.size(), object + sizeof(str));
+    }
+}
+
+unsigned test_short_strings()
+{
+    unsigned failures = 0;
+
+    utf8::string empty;
+    UTF8PP_CHECK(failures, empty.length() == 0 && empty.size() == 0);
+    UTF8PP_CHECK(failures, empty.begin() == empty.end());
+
+    utf8::string tag(u8"ταυ");
+    UTF8PP_CHECK(failures, is_local(tag));
+    UTF8PP_CHECK(failures, tag.length() == 3 && tag.size() == 6);
+    UTF8PP_CHECK(failures, tag[2] == 0x3C5);
+
+    utf8::string copy(tag);
+    UTF8PP_CHECK(failures, is_local(copy) && equals(copy, u8"ταυ"));
+
+    // growing beyond the inline buffer moves the string to the heap
+    utf8::string grown(tag);
+    while (grown.size() <= utf8::string::SHORT_CAPACITY)
+        grown += tag;
+    UTF8PP_CHECK(failures, !is_local(grown));
+    UTF8PP_CHECK(failures, grown.length() * 2 == grown.size());
+    UTF8PP_CHECK(failures, grown[grown.length() - 1] == 0x3C5);
+
+    utf8::string assigned;
+    assigned = grown;
+    UTF8PP_CHECK(failures, assigned.length() == grown.length());
+    assigned = tag;
+    UTF8PP_CHECK(failures, is_local(assigned) && equals(assigned, u8"ταυ"));
+
+    utf8::string moved(std::move(grown));
+    UTF8PP_CHECK(failures, grown.length() == 0 && grown.size() == 0);
+    UTF8PP_CHECK(failures, moved.length() * 2 == moved.size());
+
+    // the compatibility accessor still works for short strings
+    UTF8PP_CHECK(failures, tag.data().size() == 6);
+    UTF8PP_CHECK(failures, !is_local(tag) && equals(tag, u8"ταυ"));
+
+    utf8::string self(u8"ab");
+    self += self;
+    self += self;
+    UTF8PP_CHECK(failures, equals(self, "abababab") && self.length() == 8);
+
+    return failures;
+}
@@ -0,0 +1,96 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tests.hxx"
+
+#include "core/string.hxx"
+#include "core/string_view.hxx"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::size_t count(utf8::string_view view)
+    {
+        std::size_t n = 0;
+        for (utf8::value_t c : view)
+            n += c ? 1 : 0;
+        return n;
+    }
+}
+
+unsigned test_string_view()
+{
+    unsigned failures = 0;
+
+    // views of strings are validated and share their bytes
+    utf8::string const str(u8"(╯°□°）╯︵ ┻━┻");
+    utf8::string_view view = str;
+    UTF8PP_CHECK(failures, view.validated());
+    UTF8PP_CHECK(failures, view.bytes() == str.bytes() && view.size() == str.size());
+    UTF8PP_CHECK(failures, view.length() == 12 && count(view) == 12);
+    UTF8PP_CHECK(failures, view[1] == 0x256F);
+
+    // external buffers are validated on first use
+    std::string const buffer(u8"key=välue;next");
+    utf8::string_view external(buffer);
+    UTF8PP_CHECK(failures, !external.validated());
+    UTF8PP_CHECK(failures, external.length() == 14);
+    UTF8PP_CHECK(failures, external.validated());
+
+    utf8::string_view value = external.substr(4, 5);
+    UTF8PP_CHECK(failures, value.validated() && value.length() == 5 && value.size() == 6);
+    UTF8PP_CHECK(failures, value[1] == 0xE4);
+    UTF8PP_CHECK(failures, utf8::string(value).length() == 5);
+
+    utf8::string_view rest = external;
+    rest.remove_prefix(10);
+    UTF8PP_CHECK(failures, rest.length() == 4 && rest[0] == 'n');
+    rest.remove_suffix(4);
+    UTF8PP_CHECK(failures, rest.empty() && rest.begin() == rest.end());
+
+    // the suffix is dropped walking backwards, views up to the end stop at the last byte
+    utf8::string_view const mixed(u8"a€\U0001F600bä");
+    for (std::size_t count = 0; count <= mixed.length(); ++count)
+    {
+        utf8::string_view shorter = mixed, tail = mixed;
+        shorter.remove_suffix(count);
+        tail.remove_prefix(count);
+        utf8::string_view const head = mixed.substr(0, mixed.length() - count);
+        UTF8PP_CHECK(failures, shorter.bytes() == head.bytes() && shorter.size() == head.size() && shorter.length() == head.length());
+        UTF8PP_CHECK(failures, tail.bytes() + tail.size() == mixed.bytes() + mixed.size() && tail.length() == mixed.length() - count);
+    }
+
+    // invalid bytes are reported once they are used
+    utf8::string_view invalid("abc\xC0\xAF");
+    UTF8PP_CHECK(failures, !invalid.validate());
+    bool thrown = false;
+    try { invalid.length(); }
+    catch (std::invalid_argument const &) { thrown = true; }
+    UTF8PP_CHECK(failures, thrown);
+
+    thrown = false;
+    try { utf8::string copy(invalid); }
+    catch (std::invalid_argument const &) { thrown = true; }
+    UTF8PP_CHECK(failures, thrown);
+
+    return failures;
+}
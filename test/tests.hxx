@@ -0,0 +1,156 @@
+#pragma once
+
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef UTF8PP_TEST_TESTS_HXX
+#define UTF8PP_TEST_TESTS_HXX
+
+#include "core/string.hxx"
+#include "core/string_view.hxx"
+#include "core/memory_resource.hxx"
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <cstdio>
+#include <cstring>
+
+// the directory for files written by the tests (the build directory when built with CMake)
+#ifndef UTF8PP_TEST_DIR
+#define UTF8PP_TEST_DIR "."
+#endif
+
+// reports a failed check and counts it
+#define UTF8PP_CHECK(failures, condition) \
+    do { \
+        if (!(condition)) \
+        { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition "\n"; \
+            ++(failures); \
+        } \
+    } while (false)
+
+// counts the allocations it passes on to the default resource
+class counting_resource : public utf8::memory_resource
+{
+public:
+    counting_resource()
+        : allocations(0)
+        , deallocations(0)
+    {
+    }
+
+    std::size_t allocations;
+    std::size_t deallocations;
+
+private:
+    void * do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        ++allocations;
+        return utf8::resource_or_default(nullptr)->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void * p, std::size_t bytes, std::size_t alignment) override
+    {
+        ++deallocations;
+        utf8::resource_or_default(nullptr)->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(utf8::memory_resource const & other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+// true if the string holds exactly the given (valid) bytes and counted their characters right
+inline bool equals(utf8::string const & str, std::string const & bytes)
+{
+    return str.size() == bytes.size() && !std::memcmp(str.bytes(), bytes.data(), bytes.size())
+        && str.length() == utf8::string_view(bytes).length();
+}
+
+// true if calling the function throws std::invalid_argument
+template <typename Function>
+bool throws_invalid_argument(Function function)
+{
+    try { function(); }
+    catch (std::invalid_argument const &) { return true; }
+    return false;
+}
+
+// a file for the tests that is removed again, even if a test throws
+class test_file
+{
+public:
+    explicit test_file(char const * name)
+        : path_(std::string(UTF8PP_TEST_DIR) + "/" + name)
+    {
+    }
+
+    ~test_file()
+    {
+        std::remove(path_.c_str());
+    }
+
+    char const * path() const
+    {
+        return path_.c_str();
+    }
+
+    void write(std::string const & content) const
+    {
+        std::ofstream file(path_.c_str(), std::ios::binary | std::ios::trunc);
+        file.write(content.data(), content.size());
+    }
+
+private:
+    test_file(test_file const &);
+    test_file & operator = (test_file const &);
+
+    std::string path_;
+};
+
+// every test returns the number of failed checks
+unsigned test_validation();
+unsigned test_parallel_validation();
+unsigned test_offset_index();
+unsigned test_short_strings();
+unsigned test_string_view();
+unsigned test_encoding();
+unsigned test_decoding();
+unsigned test_stream_decoder();
+unsigned test_mapped_file();
+unsigned test_iterator();
+unsigned test_search();
+unsigned test_split();
+unsigned test_memory_resource();
+unsigned test_literal();
+unsigned test_error_policy();
+unsigned test_ascii();
+unsigned test_concat();
+unsigned test_comparison();
+unsigned test_intern_pool();
+unsigned test_line_reader();
+unsigned test_normalization();
+unsigned test_case_mapping();
+
+#endif // UTF8PP_TEST_TESTS_HXX
@@ -0,0 +1,320 @@
+/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tests.hxx"
+
+#include "core/string.hxx"
+#include "core/validation.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // The reference is the old decoding loop of the string constructors
+    // extended by the range checks for overlongs, surrogates and too large values.
+    utf8::detail::validation_result reference(utf8::byte_t const * strm, std::size_t size,
+                                              utf8::detail::nul_bytes nul = utf8::detail::nul_bytes::accept)
+    {
+        utf8::detail::validation_result result = { false, 0, 0, 0 };
+        std::size_t & pos = result.offset;
+        while (pos < size)
+        {
+            if (!strm[pos] && nul == utf8::detail::nul_bytes::reject)
+                return result;
+
+            if (!(strm[pos] & 0x80))
+            {
+                ++pos, ++result.length;
+                result.width = std::max(result.width, 1u);
+                continue;
+            }
+
+            unsigned charlen;
+            utf8::byte_t mask;
+            utf8::value_t minimum;
+            if ((strm[pos] & 0xE0) == 0xC0)
+                charlen = 2, mask = 0x1F, minimum = 0x80;
+            else if ((strm[pos] & 0xF0) == 0xE0)
+                charlen = 3, mask = 0x0F, minimum = 0x800;
+            else if ((strm[pos] & 0xF8) == 0xF0)
+                charlen = 4, mask = 0x07, minimum = 0x10000;
+            else
+                return result;
+
+            if (charlen > size - pos)
+                return result;
+
+            utf8::value_t value = strm[pos] & mask;
+            for (unsigned byte = 1; byte < charlen; ++byte)
+            {
+                if ((strm[pos + byte] & 0xC0) != 0x80)
+                    return result;
+                value = (value << 6) | (strm[pos + byte] & 0x3F);
+            }
+
+            if (value < minimum || (value >= 0xD800 && value <= 0xDFFF) || value > 0x10FFFF)
+                return result;
+
+            pos += charlen;
+            ++result.length;
+            result.width = std::max(result.width, charlen);
+        }
+        result.valid = true;
+        return result;
+    }
+
+    void encode(std::vector<utf8::byte_t> & out, utf8::value_t c)
+    {
+        if (c < 0x80)
+            out.push_back(static_cast<utf8::byte_t>(c));
+        else if (c < 0x800)
+        {
+            out.push_back(static_cast<utf8::byte_t>(0xC0 | (c >> 6)));
+            out.push_back(static_cast<utf8::byte_t>(0x80 | (c & 0x3F)));
+        }
+        else if (c < 0x10000)
+        {
+            out.push_back(static_cast<utf8::byte_t>(0xE0 | (c >> 12)));
+            out.push_back(static_cast<utf8::byte_t>(0x80 | ((c >> 6) & 0x3F)));
+            out.push_back(static_cast<utf8::byte_t>(0x80 | (c & 0x3F)));
+        }
+        else
+        {
+            out.push_back(static_cast<utf8::byte_t>(0xF0 | (c >> 18)));
+            out.push_back(static_cast<utf8::byte_t>(0x80 | ((c >> 12) & 0x3F)));
+            out.push_back(static_cast<utf8::byte_t>(0x80 | ((c >> 6) & 0x3F)));
+            out.push_back(static_cast<utf8::byte_t>(0x80 | (c & 0x3F)));
+        }
+    }
+
+    // mostly ASCII with some multi byte characters of every width
+    std::vector<utf8::byte_t> random_text(std::mt19937 & rng, std::size_t characters)
+    {
+        std::vector<utf8::byte_t> text;
+        for (std::size_t n = 0; n < characters; ++n)
+        {
+            utf8::value_t c;
+            switch (rng() % 8)
+            {
+            case 0: c = 0x80 + rng() % (0x800 - 0x80); break;
+            case 1: c = 0x800 + rng() % (0xD800 - 0x800); break;
+            case 2: c = 0xE000 + rng() % (0x10000 - 0xE000); break;
+            case 3: c = 0x10000 + rng() % (0x110000 - 0x10000); break;
+            default: c = 1 + rng() % 0x7F; break;
+            }
+            encode(text, c);
+        }
+        return text;
+    }
+
+    unsigned compare_kernels(std::vector<utf8::byte_t> const & text)
+    {
+        using utf8::detail::validation_kernel;
+        using utf8::detail::nul_bytes;
+
+        unsigned failures = 0;
+        validation_kernel const kernels[] = { validation_kernel::scalar, validation_kernel::sse2, validation_kernel::avx2 };
+        for (nul_bytes nul : { nul_bytes::accept, nul_bytes::reject })
+        {
+            utf8::detail::validation_result const expected = reference(text.data(), text.size(), nul);
+            for (validation_kernel kernel : kernels)
+            {
+                utf8::detail::validation_result const actual = utf8::detail::validate(text.data(), text.size(), kernel, nul);
+                UTF8PP_CHECK(failures, actual.valid == expected.valid);
+                UTF8PP_CHECK(failures, actual.length == expected.length);
+                UTF8PP_CHECK(failures, actual.offset == expected.offset);
+                UTF8PP_CHECK(failures, actual.width == expected.width);
+            }
+        }
+        return failures;
+    }
+}
+
+unsigned test_validation()
+{
+    unsigned failures = 0;
+
+    // hand picked edge cases
+    char const * const samples[] = {
+        "", "abc", u8"(╯°□°）╯︵ ┻━┻", u8"\U0010FFFF", u8"퟿",
+        "\xC0\xAF", "\xC1\xBF", "\xE0\x9F\xBF", "\xF0\x8F\xBF\xBF",   // overlongs
+        "\xED\xA0\x80", "\xED\xBF\xBF",                                 // surrogates
+        "\xF4\x90\x80\x80", "\xF5\x80\x80\x80", "\xFF",                 // too large
+        "\x80", "a\xBF", "\xC3", "\xE2\x82", "\xF0\x9F\x98",            // malformed
+        "\xC3\x28", "\xE2\x28\xA1", "\xF0\x28\x8C\xBC"
+    };
+    for (char const * sample : samples)
+    {
+        std::string const str(sample);
+        failures += compare_kernels(std::vector<utf8::byte_t>(str.begin(), str.end()));
+    }
+
+    // random valid texts with a broken byte at every position near the block boundaries
+    std::mt19937 rng(42);
+    for (std::size_t characters = 0; characters < 200; characters += 7)
+    {
+        std::vector<utf8::byte_t> text = random_text(rng, characters);
+        failures += compare_kernels(text);
+
+        for (std::size_t pos = 0; pos < text.size(); pos += 1 + rng() % 5)
+        {
+            std::vector<utf8::byte_t> broken(text);
+            broken[pos] = static_cast<utf8::byte_t>(0x80 + rng() % 0x80);
+            failures += compare_kernels(broken);
+
+            // truncated texts end in the middle of a sequence
+            failures += compare_kernels(std::vector<utf8::byte_t>(text.begin(), text.begin() + pos));
+        }
+    }
+
+    // random bytes, mostly invalid
+    for (unsigned round = 0; round < 1000; ++round)
+    {
+        std::vector<utf8::byte_t> bytes(rng() % 100);
+        for (utf8::byte_t & b : bytes)
+            b = static_cast<utf8::byte_t>(rng() % 4 ? 0x80 + rng() % 0x80 : rng() % 0x80);
+        failures += compare_kernels(bytes);
+    }
+
+    // the width of a single wide character in ASCII, before and behind an error
+    for (utf8::value_t c : { 0xE9u, 0x20ACu, 0x1F600u })
+    {
+        for (std::size_t pos = 0; pos < 100; pos += 1 + rng() % 3)
+        {
+            std::vector<utf8::byte_t> text(pos, 'a');
+            encode(text, c);
+            text.resize(text.size() + rng() % 80, 'b');
+            failures += compare_kernels(text);
+            for (std::size_t error = 0; error < text.size(); error += 1 + rng() % 13)
+            {
+                std::vector<utf8::byte_t> broken(text);
+                broken[error] = 0xFF;
+                failures += compare_kernels(broken);
+            }
+        }
+    }
+
+    // NULL bytes in ASCII and multi byte text, in the tail and in front of an error
+    for (std::size_t characters = 1; characters < 120; characters += 5)
+    {
+        std::vector<utf8::byte_t> const text = random_text(rng, characters);
+        for (std::size_t pos = 0; pos < text.size(); pos += 1 + rng() % 4)
+        {
+            std::vector<utf8::byte_t> nul(text);
+            nul[pos] = 0;
+            failures += compare_kernels(nul);
+            if (pos + 1 < nul.size())
+            {
+                nul[pos + 1 + rng() % (nul.size() - pos - 1)] = 0xFF;
+                failures += compare_kernels(nul);
+            }
+        }
+    }
+
+    // large texts exceed the counters of a single SIMD batch
+    failures += compare_kernels(random_text(rng, 100000));
+
+    // the constructors use the validator
+    bool thrown = false;
+    try { utf8::string overlong("\xC0\xAF"); }
+    catch (std::invalid_argument const &) { thrown = true; }
+    UTF8PP_CHECK(failures, thrown);
+
+    thrown = false;
+    try { utf8::string surrogate(std::string("\xED\xA0\x80")); }
+    catch (std::invalid_argument const &) { thrown = true; }
+    UTF8PP_CHECK(failures, thrown);
+
+    UTF8PP_CHECK(failures, utf8::string(u8"(-■_■)").length() == 6);
+
+    // a std::string is not cut at a NULL byte
+    thrown = false;
+    try { utf8::string nul(std::string("ab\0cd", 5)); }
+    catch (std::invalid_argument const &) { thrown = true; }
+    UTF8PP_CHECK(failures, thrown);
+
+    return failures;
+}
+
+unsigned test_parallel_validation()
+{
+    using utf8::detail::validation_kernel;
+
+    unsigned failures = 0;
+    std::mt19937 rng(7);
+
+    // chunked validation has to find the same length and the same first error
+    std::vector<utf8::byte_t> text = random_text(rng, 5000);
+    for (unsigned threads = 1; threads <= 9; ++threads)
+    {
+        for (std::size_t pos = 0; pos <= text.size(); pos += 1 + rng() % 997)
+        {
+            std::vector<utf8::byte_t> broken(text);
+            if (pos < broken.size())
+                broken[pos] = 0xFF;
+
+            // a NULL byte in front of the broken one is the first error if rejected
+            if (pos / 2 < broken.size())
+                broken[pos / 2] = 0;
+
+            for (utf8::detail::nul_bytes nul : { utf8::detail::nul_bytes::accept, utf8::detail::nul_bytes::reject })
+            {
+                utf8::detail::validation_result const expected = reference(broken.data(), broken.size(), nul);
+                utf8::detail::validation_result const actual = utf8::detail::validate_parallel(
+                    broken.data(), broken.size(), threads, utf8::detail::best_validation_kernel(), nul);
+                UTF8PP_CHECK(failures, actual.valid == expected.valid);
+                UTF8PP_CHECK(failures, actual.length == expected.length);
+                UTF8PP_CHECK(failures, actual.offset == expected.offset);
+                UTF8PP_CHECK(failures, actual.width == expected.width);
+            }
+        }
+    }
+
+    // the string constructors can be used from several threads at once
+    utf8::parallel_settings const old_settings = utf8::parallel_validation();
+    utf8::parallel_settings const settings = { 4096, 3 };
+    utf8::parallel_validation(settings);
+
+    std::string const valid(text.begin(), text.end());
+    std::size_t const length = reference(text.data(), text.size()).length;
+    std::atomic<unsigned> errors(0);
+    std::vector<std::thread> threads;
+    for (unsigned thread = 0; thread < 4; ++thread)
+    {
+        threads.emplace_back([&]() {
+            for (unsigned round = 0; round < 50; ++round)
+            {
+                if (utf8::string(valid).length() != length)
+                    ++errors;
+            }
+        });
+    }
+    for (std::thread & thread : threads)
+        thread.join();
+    UTF8PP_CHECK(failures, errors == 0);
+
+    utf8::parallel_validation(old_settings);
+    return failures;
+}
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+#
+#    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+#
+#    This file is part of utf8pp.
+#
+#    utf8pp is free software: you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation, either version 3 of the License, or
+#    (at your option) any later version.
+#
+#    utf8pp is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+
+# Generates src/core/case_tables.cxx from the Unicode database of Python
+# (str.lower(), str.upper() and str.casefold() map single characters just like
+# UnicodeData.txt, SpecialCasing.txt and CaseFolding.txt without the conditions):
+#
+#     python3 tools/case_tables.py > src/core/case_tables.cxx
+
+import sys
+import unicodedata
+
+# code points per block of the two stage table
+BLOCK = 128
+
+
+def code_points():
+    for cp in range(0x110000):
+        if not 0xD800 <= cp <= 0xDFFF:
+            yield cp
+
+
+def main():
+    pool = [0]
+    pool_index = {}
+
+    def store(mapping):
+        # mappings to several characters are stored as their length followed by the characters
+        key = tuple(ord(c) for c in mapping)
+        if key not in pool_index:
+            pool_index[key] = len(pool)
+            pool.append(len(key))
+            pool.extend(key)
+        return pool_index[key]
+
+    records = [(0, 0, 0, 0, 0, 0)]
+    record_index = {records[0]: 0}
+    values = [0] * 0x110000
+    for cp in code_points():
+        ch = chr(cp)
+        deltas, expansions = [], []
+        # in the order of case_tables::LOWER, UPPER and FOLD
+        for mapping in (ch.lower(), ch.upper(), ch.casefold()):
+            if len(mapping) == 1:
+                deltas.append(ord(mapping) - cp)
+                expansions.append(0)
+            else:
+                deltas.append(0)
+                expansions.append(store(mapping))
+
+        record = tuple(deltas + expansions)
+        if record not in record_index:
+            record_index[record] = len(records)
+            records.append(record)
+        values[cp] = record_index[record]
+
+    assert len(pool) < 0x10000 and len(records) < 0x10000
+
+    blocks = []
+    block_index = {}
+    stage1 = []
+    for start in range(0, 0x110000, BLOCK):
+        block = tuple(values[start:start + BLOCK])
+        if block not in block_index:
+            block_index[block] = len(blocks)
+            blocks.append(block)
+        stage1.append(block_index[block])
+    assert len(blocks) <= 0x100
+
+    out = sys.stdout
+    out.write(HEADER.format(version=unicodedata.unidata_version))
+
+    def array(type_name, name, items, per_line=16):
+        out.write('        {} const {}[] = {{\n'.format(type_name, name))
+        for n in range(0, len(items), per_line):
+            out.write('            ' + ', '.join(str(item) for item in items[n:n + per_line]) + ',\n')
+        out.write('        };\n\n')
+
+    array('std::uint8_t', 'stage1', stage1, 32)
+    array('std::uint16_t', 'stage2', [value for block in blocks for value in block])
+    out.write('        property const properties[] = {\n')
+    for record in records:
+        out.write('            {{ {{ {}, {}, {} }}, {{ {}, {}, {} }} }},\n'.format(*record))
+    out.write('        };\n\n')
+    array('char32_t', 'expansions', ['0x{:X}'.format(value) for value in pool], 12)
+    out.write(FOOTER)
+
+
+HEADER = '''/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Generated by tools/case_tables.py from Unicode {version}, do not edit.
+
+#include "case_tables.hxx"
+
+namespace utf8
+{{
+    namespace case_tables
+    {{
+'''
+
+FOOTER = '''    }
+}
+'''
+
+if __name__ == '__main__':
+    main()
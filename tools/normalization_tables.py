@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+#
+#    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+#
+#    This file is part of utf8pp.
+#
+#    utf8pp is free software: you can redistribute it and/or modify
+#    it under the terms of the GNU General Public License as published by
+#    the Free Software Foundation, either version 3 of the License, or
+#    (at your option) any later version.
+#
+#    utf8pp is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU General Public License for more details.
+#
+#    You should have received a copy of the GNU General Public License
+#    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+
+# Generates src/core/normalization_tables.cxx from the Unicode database of
+# Python's unicodedata module:
+#
+#     python3 tools/normalization_tables.py > src/core/normalization_tables.cxx
+
+import sys
+import unicodedata
+
+# code points per block of the two stage table
+BLOCK = 128
+
+# Hangul syllables are (de)composed algorithmically
+S_BASE, S_COUNT = 0xAC00, 11172
+V_FIRST, V_LAST = 0x1161, 0x1175
+T_FIRST, T_LAST = 0x11A8, 0x11C2
+
+# the quick check values (see normalization_tables.hxx)
+YES, MAYBE, NO = 0, 1, 2
+
+
+def code_points():
+    for cp in range(0x110000):
+        if not 0xD800 <= cp <= 0xDFFF:
+            yield cp
+
+
+def main():
+    pool = [0]
+    pool_index = {}
+
+    def store(decomposition):
+        # decompositions are stored as their length followed by the code points
+        key = tuple(decomposition)
+        if key not in pool_index:
+            pool_index[key] = len(pool)
+            pool.append(len(key))
+            pool.extend(key)
+        return pool_index[key]
+
+    # the primary composites: pairs whose canonical composition gives back the character
+    compositions = []
+    for cp in code_points():
+        if S_BASE <= cp < S_BASE + S_COUNT:
+            continue
+        decomposition = unicodedata.decomposition(chr(cp))
+        if not decomposition or decomposition.startswith('<'):
+            continue
+        parts = [int(part, 16) for part in decomposition.split()]
+        if len(parts) == 2 and unicodedata.normalize('NFC', chr(parts[0]) + chr(parts[1])) == chr(cp):
+            compositions.append((parts[0], parts[1], cp))
+    compositions.sort()
+
+    # characters which might combine with the previous one are "maybe" for the composed forms
+    combining = set(second for _, second, _ in compositions)
+    combining.update(range(V_FIRST, V_LAST + 1))
+    combining.update(range(T_FIRST, T_LAST + 1))
+
+    # characters below the minimum of a form are YES starters (in the order of the flags)
+    minimum = [0x110000] * 4
+    records = [(0, 0, 0, 0)]
+    record_index = {records[0]: 0}
+    values = [0] * 0x110000
+    for cp in code_points():
+        ch = chr(cp)
+        ccc = unicodedata.combining(ch)
+        hangul = S_BASE <= cp < S_BASE + S_COUNT
+        nfd = unicodedata.normalize('NFD', ch)
+        nfkd = unicodedata.normalize('NFKD', ch)
+
+        nfc_qc = NO if unicodedata.normalize('NFC', ch) != ch else MAYBE if cp in combining else YES
+        nfkc_qc = NO if unicodedata.normalize('NFKC', ch) != ch else MAYBE if cp in combining else YES
+        nfd_qc = NO if nfd != ch else YES
+        nfkd_qc = NO if nfkd != ch else YES
+        flags = nfc_qc | (nfkc_qc << 2) | (nfd_qc << 4) | (nfkd_qc << 6)
+        for n, qc in enumerate((nfc_qc, nfkc_qc, nfd_qc, nfkd_qc)):
+            if (qc != YES or ccc) and cp < minimum[n]:
+                minimum[n] = cp
+
+        canonical = store([ord(c) for c in nfd]) if nfd != ch and not hangul else 0
+        compatibility = store([ord(c) for c in nfkd]) if nfkd != ch and not hangul else 0
+
+        record = (ccc, flags, canonical, compatibility)
+        if record not in record_index:
+            record_index[record] = len(records)
+            records.append(record)
+        values[cp] = record_index[record]
+
+    assert len(pool) < 0x10000 and len(records) < 0x10000
+
+    blocks = []
+    block_index = {}
+    stage1 = []
+    for start in range(0, 0x110000, BLOCK):
+        block = tuple(values[start:start + BLOCK])
+        if block not in block_index:
+            block_index[block] = len(blocks)
+            blocks.append(block)
+        stage1.append(block_index[block])
+    assert len(blocks) <= 0x100
+
+    out = sys.stdout
+    out.write(HEADER.format(version=unicodedata.unidata_version))
+
+    def array(type_name, name, items, per_line=16):
+        out.write('        {} const {}[] = {{\n'.format(type_name, name))
+        for n in range(0, len(items), per_line):
+            out.write('            ' + ', '.join(str(item) for item in items[n:n + per_line]) + ',\n')
+        out.write('        };\n\n')
+
+    array('std::uint8_t', 'stage1', stage1, 32)
+    array('std::uint16_t', 'stage2', [value for block in blocks for value in block])
+    out.write('        property const properties[] = {\n')
+    for record in records:
+        out.write('            {{ {}, {}, {}, {} }},\n'.format(*record))
+    out.write('        };\n\n')
+    array('char32_t', 'decompositions', ['0x{:X}'.format(value) for value in pool], 12)
+    array('value_t', 'quick_check_minimum', ['0x{:X}'.format(value) for value in minimum])
+    array('std::uint64_t', 'composition_keys',
+          ['UINT64_C(0x{:X})'.format((first << 21) | second) for first, second, _ in compositions], 6)
+    array('char32_t', 'composition_values', ['0x{:X}'.format(composite) for _, _, composite in compositions], 12)
+    out.write('        std::size_t const composition_count = {};\n'.format(len(compositions)))
+    out.write(FOOTER)
+
+
+HEADER = '''/*
+    Copyright (C) 2012, Felix Bytow <felix.bytow@googlemail.com>
+
+    This file is part of utf8pp.
+
+    utf8pp is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    utf8pp is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with utf8pp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Generated by tools/normalization_tables.py from Unicode {version}, do not edit.
+
+#include "normalization_tables.hxx"
+
+namespace utf8
+{{
+    namespace normalization_tables
+    {{
+'''
+
+FOOTER = '''    }
+}
+'''
+
+if __name__ == '__main__':
+    main()